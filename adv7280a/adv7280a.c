@@ -25,6 +25,9 @@
 
 #define SDP_PCNT_TOLERANCE 50
 
+// Deferred write set tags
+#define ADV7280A_REGQ_LEVELS    0
+
 const adv7280a_config adv7280a_cfg_default = {
     .brightness = 128,
     .contrast = 128,
@@ -47,6 +50,9 @@ const adv7280a_config adv7280a_cfg_default = {
 };
 
 void adv7280a_writereg(adv7280a_dev *dev, uint8_t regaddr, uint8_t data) {
+    if (dev->regq)
+        regq_drop(dev->regq, dev->i2cm_base, dev->i2c_addr, regaddr, 1);
+
     I2C_start(dev->i2cm_base, dev->i2c_addr, 0);
     I2C_write(dev->i2cm_base, regaddr, 0);
     I2C_write(dev->i2cm_base, data, 1);
@@ -62,6 +68,17 @@ uint8_t adv7280a_readreg(adv7280a_dev *dev, uint8_t regaddr) {
     return I2C_read(dev->i2cm_base,1);
 }
 
+static void adv7280a_regq_begin(adv7280a_dev *dev, uint8_t tag) {
+    if (dev->regq)
+        regq_begin(dev->regq, dev->i2cm_base, dev->i2c_addr, tag);
+}
+
+// Write register at next vertical blank if deferred write queue is attached (and not full)
+static void adv7280a_writereg_vsync(adv7280a_dev *dev, uint8_t regaddr, uint8_t data) {
+    if (!dev->regq || (regq_write(dev->regq, dev->i2cm_base, dev->i2c_addr, regaddr, data) != 0))
+        adv7280a_writereg(dev, regaddr, data);
+}
+
 void adv7280a_get_default_cfg(adv7280a_config *cfg) {
     memcpy(cfg, &adv7280a_cfg_default, sizeof(adv7280a_config));
 }
@@ -152,9 +169,10 @@ void adv7280a_set_gains(adv7280a_dev *dev, uint8_t y_gain_mode, uint16_t y_gain,
 }
 
 void adv7280a_set_levels(adv7280a_dev *dev, uint8_t brightness, uint8_t contrast, uint8_t hue) {
-    adv7280a_writereg(dev, 0x0a, brightness-128);
-    adv7280a_writereg(dev, 0x08, contrast);
-    adv7280a_writereg(dev, 0x0b, hue-128);
+    adv7280a_regq_begin(dev, ADV7280A_REGQ_LEVELS);
+    adv7280a_writereg_vsync(dev, 0x08, contrast);
+    adv7280a_writereg_vsync(dev, 0x0a, brightness-128);
+    adv7280a_writereg_vsync(dev, 0x0b, hue-128);
 }
 
 void adv7280a_set_shfilt(adv7280a_dev *dev, uint8_t sh_filt_y, uint8_t sh_filt_y2, uint8_t sh_filt_c) {
@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include "sysconfig.h"
+#include "regq.h"
 #include "adv7280a_regs.h"
 
 typedef enum {
@@ -85,6 +86,7 @@ typedef struct {
     uint8_t powered_on;
     adv7280a_config cfg;
     adv7280a_sync_status ss;
+    regq_t *regq;
 } adv7280a_dev;
 
 int adv7280a_init(adv7280a_dev *dev);
@@ -21,6 +21,9 @@
 #include "adv7513.h"
 #include "i2c_opencores.h"
 
+// Deferred write set tags
+#define ADV7513_REGQ_CSC    0
+
 const adv7513_config adv7513_cfg_default = {
     .tx_mode = TX_HDMI_RGB_FULL,
     .audio_fmt = AUDIO_I2S,
@@ -32,6 +35,9 @@ const adv7513_config adv7513_cfg_default = {
 
 void adv7513_writereg(adv7513_dev *dev, uint8_t regaddr, uint8_t data)
 {
+    if (dev->regq)
+        regq_drop(dev->regq, dev->i2cm_base, (dev->main_base>>1), regaddr, 1);
+
     I2C_start(dev->i2cm_base, (dev->main_base>>1), 0);
     I2C_write(dev->i2cm_base, regaddr, 0);
     I2C_write(dev->i2cm_base, data, 1);
@@ -66,6 +72,27 @@ uint8_t adv7513_readreg_pktmem(adv7513_dev *dev, uint8_t regaddr)
     return I2C_read(dev->i2cm_base,1);
 }
 
+static void adv7513_regq_begin(adv7513_dev *dev, uint8_t tag) {
+    if (dev->regq)
+        regq_begin(dev->regq, dev->i2cm_base, (dev->main_base>>1), tag);
+}
+
+// Write register at next vertical blank if deferred write queue is attached (and not full)
+static void adv7513_writereg_vsync(adv7513_dev *dev, uint8_t regaddr, uint8_t data) {
+    if (!dev->regq || (regq_write(dev->regq, dev->i2cm_base, (dev->main_base>>1), regaddr, data) != 0))
+        adv7513_writereg(dev, regaddr, data);
+}
+
+// Read register value including not yet flushed deferred writes
+static uint8_t adv7513_readreg_vsync(adv7513_dev *dev, uint8_t regaddr) {
+    uint8_t data;
+
+    if (dev->regq && regq_read_pending(dev->regq, dev->i2cm_base, (dev->main_base>>1), regaddr, &data))
+        return data;
+
+    return adv7513_readreg(dev, regaddr);
+}
+
 int adv7513_init(adv7513_dev *dev) {
     memcpy(&dev->cfg, &adv7513_cfg_default, sizeof(adv7513_config));
 
@@ -144,6 +171,9 @@ void adv7513_get_default_cfg(adv7513_config *cfg) {
     memcpy(cfg, &adv7513_cfg_default, sizeof(adv7513_config));
 }
 
+// Recommended audio clock regeneration N values indexed by IEC60958 fs code (0 = use default)
+static const uint16_t audio_n_arr[] = {6272, 0, 6144, 4096, 0, 0, 0, 0, 12544, 0, 12288, 0, 25088, 0, 24576, 0};
+
 void adv7513_set_audio(adv7513_dev *dev, HDMI_audio_fmt_t fmt, HDMI_i2s_fs_t i2s_fs, HDMI_i2s_stereo_cfg_t i2s_stereo_cfg, HDMI_audio_cc_t cc_val, HDMI_audio_ca_t ca_val) {
     uint32_t N=6144;
     uint8_t val;
@@ -158,31 +188,8 @@ void adv7513_set_audio(adv7513_dev *dev, HDMI_audio_fmt_t fmt, HDMI_i2s_fs_t i2s
         adv7513_writereg(dev, 0x0A, 0x00);
         adv7513_writereg(dev, 0x0B, 0x0e);
 
-        switch (i2s_fs) {
-            case IEC60958_FS_32KHZ:
-                N = 4096;
-                break;
-            case IEC60958_FS_44P1KHZ:
-                N = 6272;
-                break;
-            case IEC60958_FS_48KHZ:
-                N = 6144;
-                break;
-            case IEC60958_FS_88P2KHZ:
-                N = 12544;
-                break;
-            case IEC60958_FS_96KHZ:
-                N = 12288;
-                break;
-            case IEC60958_FS_176P4KHZ:
-                N = 25088;
-                break;
-            case IEC60958_FS_192KHZ:
-                N = 24576;
-                break;
-            default:
-                break;
-        }
+        if (audio_n_arr[i2s_fs & 0xf])
+            N = audio_n_arr[i2s_fs & 0xf];
 
         val = adv7513_readreg(dev, 0x15) & 0x0f;
         adv7513_writereg(dev, 0x15, val | (i2s_fs<<4));
@@ -305,21 +312,23 @@ void adv7513_set_csc_mode(adv7513_dev *dev, uint8_t enable, HDMI_colorspace_t sr
                                       0x00, 0x00, 0x00, 0x00, 0x0d, 0xbc, 0x01, 0x00};
     int i;
 
+    adv7513_regq_begin(dev, ADV7513_REGQ_CSC);
+
     if (!enable) {
-        val = adv7513_readreg(dev, 0x18) & ~(1<<7);
-        adv7513_writereg(dev, 0x18, val);
+        val = adv7513_readreg_vsync(dev, 0x18) & ~(1<<7);
+        adv7513_writereg_vsync(dev, 0x18, val);
     } else {
         if ((src==CS_RGB_FULL) && (dst==CS_YCBCR_709)) {
             for (i=0; i<sizeof(coeffs_rgbf_ycbcr709)/sizeof(uint8_t); i++)
-                adv7513_writereg(dev, 0x18+i, coeffs_rgbf_ycbcr709[i]);
+                adv7513_writereg_vsync(dev, 0x18+i, coeffs_rgbf_ycbcr709[i]);
         } else if ((src==CS_RGB_FULL) && (dst==CS_RGB_LIMITED)) {
             for (i=0; i<sizeof(coeffs_rgbf_rgbl)/sizeof(uint8_t); i++)
-                adv7513_writereg(dev, 0x18+i, coeffs_rgbf_rgbl[i]);
+                adv7513_writereg_vsync(dev, 0x18+i, coeffs_rgbf_rgbl[i]);
         }
     }
 
-    val = adv7513_readreg(dev, 0x16) & ~(1<<0);
-    adv7513_writereg(dev, 0x16, val | (dst>CS_RGB_LIMITED));
+    val = adv7513_readreg_vsync(dev, 0x16) & ~(1<<0);
+    adv7513_writereg_vsync(dev, 0x16, val | (dst>CS_RGB_LIMITED));
 }
 
 void adv7513_set_pixelrep_vic(adv7513_dev *dev, uint8_t pixelrep, uint8_t pixelrep_infoframe, HDMI_vic_t vic) {
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include "sysconfig.h"
 #include "hdmi.h"
+#include "regq.h"
 #include "adv7513_regs.h"
 
 typedef struct {
@@ -48,6 +49,7 @@ typedef struct {
     uint8_t pixelrep_infoframe;
     HDMI_vic_t vic;
     adv7513_config cfg;
+    regq_t *regq;
 } adv7513_dev;
 
 int adv7513_init(adv7513_dev *dev);
@@ -26,14 +26,65 @@
 
 #define PCLK_HZ_TOLERANCE 1000000UL
 
+#define PCLK_FILT_ALPHA_SHIFT   2           // EWMA weight 1/4
+#define PCLK_FILT_SNAP_HZ       (4*PCLK_HZ_TOLERANCE)   // jump EWMA directly to median beyond this
+
+// IO_REG_14 setting threshold for high pclk and hysteresis around it
+#define PCLK_IO14_THOLD_HZ      100000000UL
+#define PCLK_IO14_HYST_HZ       2000000UL
+
+// Max number of unchanged bytes between EDID differences to still write in same burst
+#define EDID_DIFF_MERGE_GAP 4
+
+// Max bytes per EDID write transaction. i2c_opencores has no FIFO limit, but shorter bursts
+// bound the time the bus is held from other devices during EDID switch.
+#define EDID_WRITE_CHUNK    32
+
+// Time E-EDID controller is kept in reset during EDID switch so that source notices the change,
+// and sleep interval of blocking adv761x_update_edid() while waiting for it
+#define EDID_RESET_HOLD_MS  100
+#define EDID_SWITCH_POLL_US 10000
+
 // Spoof XTAL frequency to a lower value get past 165MHz soft limitation for pclk
 #define SPOOF_XTAL_FREQ
 
+typedef struct {
+    uint8_t st_reg;
+    uint8_t clr_reg;
+    uint8_t mask_reg;
+} adv761x_irq_group;
+
+static const adv761x_irq_group adv761x_irq_groups[] = {
+    {ADV761X_HDMI_LVL_INT_ST_3, ADV761X_HDMI_LVL_INT_CLR_3, ADV761X_HDMI_LVL_INT_MASK_3},
+    {ADV761X_HDMI_LVL_INT_ST_4, ADV761X_HDMI_LVL_INT_CLR_4, ADV761X_HDMI_LVL_INT_MASK_4},
+    {ADV761X_NEW_IFR_INT_ST,    ADV761X_NEW_IFR_INT_CLR,    ADV761X_NEW_IFR_INT_MASK},
+    {ADV761X_AUDIO_INT_ST,      ADV761X_AUDIO_INT_CLR,      ADV761X_AUDIO_INT_MASK},
+};
+
+#define ADV761X_IRQ_GROUPS (sizeof(adv761x_irq_groups)/sizeof(adv761x_irq_group))
+
+// Status bit location of each hardware event
+static const struct {
+    uint8_t group;
+    uint8_t bit;
+    adv761x_event ev;
+} adv761x_irq_map[] = {
+    {0, (1<<4), ADV761X_EV_TMDS_CLK},
+    {0, (1<<0), ADV761X_EV_DE_REGEN_LCK},
+    {0, (1<<1), ADV761X_EV_V_LOCKED},
+    {2, (1<<0), ADV761X_EV_NEW_AVI_IFR},
+    {2, (1<<1), ADV761X_EV_NEW_AUDIO_IFR},
+    {2, (1<<2), ADV761X_EV_NEW_SPD_IFR},
+    {3, (1<<3), ADV761X_EV_AUDIO_FS_CHANGE},
+    {1, (1<<0), ADV761X_EV_CABLE_DET},
+};
+
 const adv761x_config adv761x_cfg_default = {
     .default_rgb_range = ADV761X_RGB_LIMITED,
     .pixelderep_mode = 1,
     .enable_dv1 = 1,
-    .enable_dv1_menu = 1
+    .enable_dv1_menu = 1,
+    .dropout_grace_polls = 3
 };
 
 uint8_t adv761x_get_baseaddr(adv761x_dev *dev, adv761x_reg_map map) {
@@ -79,6 +130,33 @@ uint8_t adv761x_readreg(adv761x_dev *dev, adv761x_reg_map map, uint8_t regaddr)
     return I2C_read(dev->i2cm_base,1);
 }
 
+void adv761x_writeregs(adv761x_dev *dev, adv761x_reg_map map, uint8_t regaddr, const uint8_t *buf, unsigned len)
+{
+    uint8_t baseaddr = adv761x_get_baseaddr(dev, map);
+    unsigned i;
+
+    I2C_start(dev->i2cm_base, (baseaddr>>1), 0);
+    I2C_write(dev->i2cm_base, regaddr, 0);
+
+    for (i=0; i<len; i++)
+        I2C_write(dev->i2cm_base, buf[i], (i == len-1));
+}
+
+void adv761x_readregs(adv761x_dev *dev, adv761x_reg_map map, uint8_t regaddr, uint8_t *buf, unsigned len)
+{
+    uint8_t baseaddr = adv761x_get_baseaddr(dev, map);
+    unsigned i;
+
+    //Phase 1
+    I2C_start(dev->i2cm_base, (baseaddr>>1), 0);
+    I2C_write(dev->i2cm_base, regaddr, 0);
+
+    //Phase 2
+    I2C_start(dev->i2cm_base, (baseaddr>>1), 1);
+    for (i=0; i<len; i++)
+        buf[i] = I2C_read(dev->i2cm_base, (i == len-1));
+}
+
 void adv761x_init(adv761x_dev *dev) {
     unsigned edid_cur = dev->cfg.edid_sel;
 
@@ -86,6 +164,9 @@ void adv761x_init(adv761x_dev *dev) {
     memcpy(&dev->cfg, &adv761x_cfg_default, sizeof(adv761x_config));
     dev->cfg.edid_sel = edid_cur;
 
+    // IO_REG_14 is written on first mode change
+    dev->io_reg_14 = 0;
+
     // Set I2C mapping
     adv761x_writereg(dev, ADV761X_IO_MAP, ADV761X_CEC_SLAVEADDR, dev->cec_base);
     adv761x_writereg(dev, ADV761X_IO_MAP, ADV761X_INFRM_SLAVEADDR, dev->infoframe_base);
@@ -172,36 +253,165 @@ void adv761x_enable_power(adv761x_dev *dev, int enable) {
     dev->powered_on = enable;
 }
 
-int adv761x_update_edid(adv761x_dev *dev, unsigned edid_id) {
-    int i;
+static void adv761x_write_edid_burst(adv761x_dev *dev, unsigned offset, const uint8_t *data, unsigned len) {
+    unsigned chunk;
+
+    while (len) {
+        chunk = (len > EDID_WRITE_CHUNK) ? EDID_WRITE_CHUNK : len;
+        adv761x_writeregs(dev, ADV761X_EDID_MAP, offset, data, chunk);
+        offset += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+}
+
+// Write differing bytes of an EDID segment, merging runs separated by short unchanged gaps into one burst
+static void adv761x_write_edid_segment(adv761x_dev *dev, unsigned seg, const uint8_t *data, const uint8_t *shadow, unsigned len) {
+    unsigned i, start, end;
+
+    adv761x_writereg(dev, ADV761X_KSV_MAP, 0x7a, 4+seg);
+
+    if (!shadow) {
+        adv761x_write_edid_burst(dev, 0x00, data, len);
+        return;
+    }
+
+    i = 0;
+    while (i < len) {
+        if (data[i] == shadow[i]) {
+            i++;
+            continue;
+        }
+
+        start = end = i;
+        for (i=start+1; (i<len) && (i<=end+EDID_DIFF_MERGE_GAP); i++) {
+            if (data[i] != shadow[i])
+                end = i;
+        }
+
+        adv761x_write_edid_burst(dev, start, data+start, end-start+1);
+        i = end+1;
+    }
+}
+
+// Read back each block in segment with a single burst and compare against expected data
+static int adv761x_verify_edid_segment(adv761x_dev *dev, unsigned seg, const uint8_t *data, unsigned len) {
+    uint8_t buf[128];
+    unsigned blk;
+
+    adv761x_writereg(dev, ADV761X_KSV_MAP, 0x7a, 4+seg);
+
+    for (blk=0; blk<len/128; blk++) {
+        adv761x_readregs(dev, ADV761X_EDID_MAP, blk*128, buf, 128);
+        if (memcmp(buf, data+blk*128, 128))
+            return -1;
+    }
+
+    return 0;
+}
+
+// Time base for EDID reset hold. Without dev->get_ms only the blocking adv761x_update_edid() advances it.
+static uint32_t adv761x_get_ms(adv761x_dev *dev) {
+    return dev->get_ms ? dev->get_ms() : dev->sw_ms;
+}
+
+// Begin EDID switch. Progress is made in adv761x_edid_switch_poll() so that other devices keep being serviced meanwhile.
+// Non-blocking use requires dev->get_ms for the reset hold.
+int adv761x_edid_switch_start(adv761x_dev *dev, unsigned edid_id) {
     const edid_t *target_edid = dev->edid_list[edid_id];
 
     // check if length is valid
     if ((target_edid->data[126]+1)*128 != target_edid->len)
         return -1;
 
+    dev->edid_target = edid_id;
+    dev->edid_offset = 0;
+
+    // Shadow is also updated per segment, so invalidate it for an upload of different size
+    if (dev->edid_shadow_len != target_edid->len)
+        dev->edid_shadow_len = 0;
+
+    // restarted during reset hold: EDID is already disabled, but the full hold must still pass before upload
+    if (dev->edid_state == ADV761X_EDID_RESET_WAIT)
+        return 0;
+
     // check if EDID enabled on port
     if (adv761x_readreg(dev, ADV761X_KSV_MAP, 0x76) & 0x01) {
         // return if requested EDID is already active
-        if (edid_id == dev->cfg.edid_sel)
+        if (edid_id == dev->cfg.edid_sel) {
+            dev->edid_state = ADV761X_EDID_IDLE;
             return 0;
+        }
 
         // disable EDID and reset E-EDID controller
         adv761x_writereg(dev, ADV761X_KSV_MAP, 0x74, 0x00);
         adv761x_writereg(dev, ADV761X_HDMI_MAP, ADV761X_HDMI_REG_5AH, (1<<3));
-        usleep(100000);
+
+        dev->edid_reset_ms = adv761x_get_ms(dev);
+        dev->edid_state = ADV761X_EDID_RESET_WAIT;
+    } else {
+        dev->edid_state = ADV761X_EDID_UPLOAD;
     }
 
-    adv761x_writereg(dev, ADV761X_KSV_MAP, 0x7a, 4);
+    return 0;
+}
+
+// Advance EDID switch by one step: wait after reset, upload one 256-byte segment, or enable EDID after last segment
+adv761x_edid_state adv761x_edid_switch_poll(adv761x_dev *dev) {
+    unsigned seg_len;
+    const uint8_t *shadow;
+    const edid_t *target_edid = dev->edid_list[dev->edid_target];
+
+    switch (dev->edid_state) {
+        case ADV761X_EDID_RESET_WAIT:
+            if ((uint32_t)(adv761x_get_ms(dev) - dev->edid_reset_ms) >= EDID_RESET_HOLD_MS)
+                dev->edid_state = ADV761X_EDID_UPLOAD;
+            break;
+        case ADV761X_EDID_UPLOAD:
+            seg_len = target_edid->len - dev->edid_offset;
+            if (seg_len > 256)
+                seg_len = 256;
+
+            // Upload only differences to previously programmed EDID in auto-increment bursts
+            shadow = dev->edid_shadow_len ? dev->edid_shadow+dev->edid_offset : NULL;
+
+            if (!shadow || memcmp(shadow, target_edid->data+dev->edid_offset, seg_len))
+                adv761x_write_edid_segment(dev, dev->edid_offset/256, target_edid->data+dev->edid_offset, shadow, seg_len);
+
+            // Rewrite whole segment if RAM contents do not match cached copy
+            if (adv761x_verify_edid_segment(dev, dev->edid_offset/256, target_edid->data+dev->edid_offset, seg_len) != 0) {
+                printf("EDID segment %u verify failed, rewriting\n", dev->edid_offset/256);
+                adv761x_write_edid_segment(dev, dev->edid_offset/256, target_edid->data+dev->edid_offset, NULL, seg_len);
+            }
+
+            memcpy(dev->edid_shadow+dev->edid_offset, target_edid->data+dev->edid_offset, seg_len);
+            dev->edid_offset += seg_len;
+
+            if (dev->edid_offset >= target_edid->len) {
+                dev->edid_shadow_len = target_edid->len;
 
-    for (i=0; i<target_edid->len; i++) {
-        if (i == 256)
-            adv761x_writereg(dev, ADV761X_KSV_MAP, 0x7a, 5);
-        adv761x_writereg(dev, ADV761X_EDID_MAP, (i%256), target_edid->data[i]);
+                // enable EDID on port
+                adv761x_writereg(dev, ADV761X_KSV_MAP, 0x74, 0x01);
+                dev->edid_state = ADV761X_EDID_IDLE;
+            }
+            break;
+        default:
+            break;
     }
 
-    // enable EDID on port
-    adv761x_writereg(dev, ADV761X_KSV_MAP, 0x74, 0x01);
+    return dev->edid_state;
+}
+
+int adv761x_update_edid(adv761x_dev *dev, unsigned edid_id) {
+    if (adv761x_edid_switch_start(dev, edid_id) != 0)
+        return -1;
+
+    while (adv761x_edid_switch_poll(dev) != ADV761X_EDID_IDLE) {
+        if (dev->edid_state == ADV761X_EDID_RESET_WAIT) {
+            usleep(EDID_SWITCH_POLL_US);
+            dev->sw_ms += EDID_SWITCH_POLL_US/1000;
+        }
+    }
 
     return 0;
 }
@@ -231,6 +441,10 @@ int adv761x_check_activity(adv761x_dev *dev) {
     uint8_t sync_activity, sync_active;
     int activity_change = 0;
 
+    // keep EDID switch running from main loop
+    if (dev->edid_state != ADV761X_EDID_IDLE)
+        adv761x_edid_switch_poll(dev);
+
     /*retval = adv761x_readreg(ADV761X_IO_BASE, 0x6f);
     printf("+5V det: 0x%lx\n", retval);
 
@@ -259,12 +473,31 @@ int adv761x_check_activity(adv761x_dev *dev) {
     sync_activity = adv761x_readreg(dev, ADV761X_IO_MAP, ADV761X_HDMI_LVL_RAW_STAT_3);
     sync_active = !!(sync_activity & 0x1);
 
+    // Hold last sync status over short dropouts (e.g. HDCP re-auth) and let get_sync_stats compare timing once lock returns
+    if (dev->grace_polls) {
+        if (sync_active) {
+            dev->grace_polls = 0;
+            dev->resume_check = 1;
+            return 0;
+        } else if (--dev->grace_polls) {
+            return 0;
+        }
+        printf("advrx dropout grace expired\n");
+    } else if (dev->sync_active && !sync_active && dev->cfg.dropout_grace_polls) {
+        dev->grace_polls = dev->cfg.dropout_grace_polls;
+        dev->stats.dropouts++;
+        return 0;
+    }
+
     if (sync_active != dev->sync_active) {
         activity_change = 1;
         memset(&dev->ss, 0, sizeof(adv761x_sync_status));
         dev->pclk_hz = 0;
+        dev->pclk_filt.num = 0;
         dev->pixelderep = 0;
         dev->pixelderep_ifr = 0;
+        dev->ifr.valid = 0;
+        dev->resume_check = 0;
 
         printf("advrx activity: 0x%lx\n", sync_activity);
     }
@@ -274,77 +507,277 @@ int adv761x_check_activity(adv761x_dev *dev) {
     return activity_change;
 }
 
+// Re-read packets in ifr_mask whose checksum or "new infoframe" status changed. Changes are also
+// accumulated into dev->ifr.changed so that they are reported by adv761x_update_infoframes()
+// regardless of which path refreshed the cache.
+static uint8_t adv761x_refresh_infoframes(adv761x_dev *dev, uint8_t new_ifr, uint8_t ifr_mask) {
+    uint8_t *ifr_buf[] = {dev->ifr.avi, dev->ifr.audio, dev->ifr.spd};
+    const uint8_t ifr_len[] = {sizeof(dev->ifr.avi), sizeof(dev->ifr.audio), sizeof(dev->ifr.spd)};
+    const uint8_t ifr_regaddr[] = {ADV761X_AVI_INFOFRAME_PB0, ADV761X_AUD_INFOFRAME_PB0, ADV761X_SPD_INFOFRAME_PB0};
+    uint8_t buf[sizeof(dev->ifr.spd)];
+    uint8_t changed = 0;
+    int i;
+
+    for (i=0; i<ADV761X_IFR_NUM; i++) {
+        if (!(ifr_mask & (1<<i)))
+            continue;
+
+        if ((dev->ifr.valid & (1<<i)) && !(new_ifr & (1<<i)) && (adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ifr_regaddr[i]) == ifr_buf[i][0]))
+            continue;
+
+        adv761x_readregs(dev, ADV761X_INFOFRAME_MAP, ifr_regaddr[i], buf, ifr_len[i]);
+
+        if (!(dev->ifr.valid & (1<<i)) || memcmp(buf, ifr_buf[i], ifr_len[i])) {
+            memcpy(ifr_buf[i], buf, ifr_len[i]);
+            changed |= (1<<i);
+        }
+        dev->ifr.valid |= (1<<i);
+    }
+
+    dev->ifr.changed |= changed;
+
+    return changed;
+}
+
+// Refresh all cached packets, consuming latched "new infoframe" status. Used internally so that
+// dev->ifr.changed is left for adv761x_update_infoframes() to report.
+static void adv761x_poll_infoframes(adv761x_dev *dev) {
+    uint8_t new_ifr;
+
+    new_ifr = adv761x_readreg(dev, ADV761X_IO_MAP, ADV761X_NEW_IFR_INT_ST) & ((1<<ADV761X_IFR_NUM)-1);
+    if (new_ifr)
+        adv761x_writereg(dev, ADV761X_IO_MAP, ADV761X_NEW_IFR_INT_CLR, new_ifr);
+
+    adv761x_refresh_infoframes(dev, new_ifr, (1<<ADV761X_IFR_NUM)-1);
+}
+
+// Refresh cached infoframe packets whose checksum or "new infoframe" status changed. Returns mask of packets
+// changed since previous call, including changes picked up by IRQ handling, adv761x_get_sync_stats() or
+// adv761x_get_audio_status().
+uint8_t adv761x_update_infoframes(adv761x_dev *dev) {
+    uint8_t changed;
+
+    adv761x_poll_infoframes(dev);
+
+    changed = dev->ifr.changed;
+    dev->ifr.changed = 0;
+
+    return changed;
+}
+
+// Enable latched status and INT1 output for selected hardware events
+void adv761x_enable_irq(adv761x_dev *dev, uint16_t ev_mask) {
+    uint8_t mask[ADV761X_IRQ_GROUPS] = {0};
+    unsigned i;
+
+    for (i=0; i<sizeof(adv761x_irq_map)/sizeof(adv761x_irq_map[0]); i++) {
+        if (ev_mask & adv761x_irq_map[i].ev)
+            mask[adv761x_irq_map[i].group] |= adv761x_irq_map[i].bit;
+    }
+
+    // INT1 active low, asserted until cleared
+    adv761x_writereg(dev, ADV761X_IO_MAP, ADV761X_IO_REG_40, 0xc1);
+
+    for (i=0; i<ADV761X_IRQ_GROUPS; i++) {
+        adv761x_writereg(dev, ADV761X_IO_MAP, adv761x_irq_groups[i].mask_reg, mask[i]);
+        adv761x_writereg(dev, ADV761X_IO_MAP, adv761x_irq_groups[i].clr_reg, 0xff);
+    }
+
+    dev->irq_mask = ev_mask & ADV761X_EV_HW_MASK;
+    dev->sync_update_pending = 1;
+}
+
+// Read and clear latched status, either on INT1 assertion or periodically. Timings are re-read only on lock/mode events.
+// Dropout grace window is counted in calls and EDID switch is advanced here, so when driven by INT1, this must also be
+// called periodically (at the check_activity poll rate) while adv761x_poll_required() returns nonzero.
+uint16_t adv761x_service_irq(adv761x_dev *dev) {
+    uint8_t st[ADV761X_IRQ_GROUPS], resume_check;
+    uint16_t events = 0;
+    unsigned i;
+
+    for (i=0; i<ADV761X_IRQ_GROUPS; i++) {
+        st[i] = adv761x_readreg(dev, ADV761X_IO_MAP, adv761x_irq_groups[i].st_reg);
+        if (st[i])
+            adv761x_writereg(dev, ADV761X_IO_MAP, adv761x_irq_groups[i].clr_reg, st[i]);
+    }
+
+    for (i=0; i<sizeof(adv761x_irq_map)/sizeof(adv761x_irq_map[0]); i++) {
+        if (st[adv761x_irq_map[i].group] & adv761x_irq_map[i].bit)
+            events |= adv761x_irq_map[i].ev;
+    }
+    events &= dev->irq_mask;
+
+    if ((events & ADV761X_EV_LOCK_MASK) || dev->grace_polls) {
+        if (adv761x_check_activity(dev)) {
+            events |= ADV761X_EV_ACTIVITY_CHANGE;
+            dev->sync_update_pending = 1;
+        }
+    } else if (dev->edid_state != ADV761X_EDID_IDLE) {
+        // done by check_activity() otherwise
+        adv761x_edid_switch_poll(dev);
+    }
+
+    if (events & (ADV761X_EV_NEW_AVI_IFR|ADV761X_EV_NEW_AUDIO_IFR|ADV761X_EV_NEW_SPD_IFR))
+        adv761x_refresh_infoframes(dev, st[2] & ((1<<ADV761X_IFR_NUM)-1), (1<<ADV761X_IFR_NUM)-1);
+
+    if (dev->sync_active && (dev->sync_update_pending || (events & (ADV761X_EV_LOCK_MASK|ADV761X_EV_NEW_AVI_IFR|ADV761X_EV_NEW_SPD_IFR)))) {
+        resume_check = dev->resume_check;
+        if (adv761x_get_sync_stats(dev))
+            events |= ADV761X_EV_MODE_CHANGE;
+        else if (resume_check && !dev->resume_check)
+            events |= ADV761X_EV_RESUMED;
+    }
+
+    return events;
+}
+
+// Returns nonzero while driver has pending work that is not signaled via INT1
+int adv761x_poll_required(adv761x_dev *dev) {
+    return (dev->grace_polls != 0) || (dev->edid_state != ADV761X_EDID_IDLE);
+}
+
+void adv761x_read_timing_snapshot(adv761x_dev *dev, adv761x_timing_snapshot *snap) {
+    snap->raw_stat_3 = adv761x_readreg(dev, ADV761X_IO_MAP, ADV761X_HDMI_LVL_RAW_STAT_3);
+    adv761x_readregs(dev, ADV761X_HDMI_MAP, ADV761X_HDMI_REG_05H, snap->hdmi, sizeof(snap->hdmi));
+    adv761x_readregs(dev, ADV761X_HDMI_MAP, ADV761X_TMDSFREQ_1, snap->tmdsfreq, sizeof(snap->tmdsfreq));
+}
+
+static uint16_t adv761x_snap_word(const adv761x_timing_snapshot *snap, uint8_t regaddr, uint8_t msb_mask) {
+    return ((ADV761X_SNAP_REG(snap, regaddr) & msb_mask) << 8) | ADV761X_SNAP_REG(snap, regaddr+1);
+}
+
+// Decode timing snapshot into sync status. Returns 0 if vertical parameters are not valid.
+int adv761x_decode_sync_status(const adv761x_timing_snapshot *snap, adv761x_sync_status *ss) {
+    uint8_t regval;
+
+    memset(ss, 0, sizeof(adv761x_sync_status));
+
+    ss->h_total = adv761x_snap_word(snap, ADV761X_TOTAL_LINE_WIDTH_1, 0x3f);
+    ss->h_synclen = adv761x_snap_word(snap, ADV761X_HSYNC_PULSEWIDTH_1, 0x1f);
+    ss->h_backporch = adv761x_snap_word(snap, ADV761X_HSYNC_BACKPORCH_1, 0x1f);
+    ss->h_active = adv761x_snap_word(snap, ADV761X_LINE_WIDTH_1, 0x1f);
+
+    // Check if V params are valid
+    if (!(snap->raw_stat_3 & (1<<1)))
+        return 0;
+
+    ss->interlace_flag = !!(ADV761X_SNAP_REG(snap, ADV761X_FIELD1_HEIGHT_1) & (1<<5));
+
+    if (!ss->interlace_flag) {
+        ss->v_total = adv761x_snap_word(snap, ADV761X_FIELD0_TOT_HEIGHT_1, 0x3f)/2;
+        ss->v_synclen = adv761x_snap_word(snap, ADV761X_FIELD0_VS_WIDTH_1, 0x3f)/2;
+        ss->v_backporch = adv761x_snap_word(snap, ADV761X_FIELD0_VS_BPORCH_1, 0x3f)/2;
+        ss->v_active = adv761x_snap_word(snap, ADV761X_FIELD0_HEIGHT_1, 0x1f);
+    } else {
+        ss->v_total = (adv761x_snap_word(snap, ADV761X_FIELD0_TOT_HEIGHT_1, 0x3f) + adv761x_snap_word(snap, ADV761X_FIELD1_TOT_HEIGHT_1, 0x3f))/2;
+        ss->v_synclen = (adv761x_snap_word(snap, ADV761X_FIELD0_VS_WIDTH_1, 0x3f) + adv761x_snap_word(snap, ADV761X_FIELD1_VS_WIDTH_1, 0x3f))/4;
+        ss->v_backporch = (adv761x_snap_word(snap, ADV761X_FIELD0_VS_BPORCH_1, 0x3f) + adv761x_snap_word(snap, ADV761X_FIELD1_VS_BPORCH_1, 0x3f))/4;
+        ss->v_active = (adv761x_snap_word(snap, ADV761X_FIELD0_HEIGHT_1, 0x1f) + adv761x_snap_word(snap, ADV761X_FIELD1_HEIGHT_1, 0x1f))/2;
+    }
+
+    regval = ADV761X_SNAP_REG(snap, ADV761X_HDMI_REG_05H);
+    ss->h_polarity = !!(regval & (1<<5));
+    ss->v_polarity = !!(regval & (1<<4));
+
+    return 1;
+}
+
+static void adv761x_pclk_filter_reset(adv761x_pclk_filter *filt, uint32_t pclk_hz) {
+    filt->samples[0] = pclk_hz;
+    filt->idx = 1;
+    filt->num = 1;
+    filt->ewma_hz = pclk_hz;
+}
+
+// Median of last ADV761X_PCLK_MEDIAN_N samples smoothed by EWMA
+static uint32_t adv761x_pclk_filter_update(adv761x_pclk_filter *filt, uint32_t pclk_hz) {
+    uint32_t sorted[ADV761X_PCLK_MEDIAN_N], tmp, median;
+    int32_t diff;
+    int i, j;
+
+    filt->samples[filt->idx] = pclk_hz;
+    filt->idx = (filt->idx+1) % ADV761X_PCLK_MEDIAN_N;
+    if (filt->num < ADV761X_PCLK_MEDIAN_N)
+        filt->num++;
+
+    memcpy(sorted, filt->samples, filt->num*sizeof(uint32_t));
+    for (i=1; i<filt->num; i++) {
+        tmp = sorted[i];
+        for (j=i; (j>0) && (sorted[j-1] > tmp); j--)
+            sorted[j] = sorted[j-1];
+        sorted[j] = tmp;
+    }
+    median = sorted[filt->num/2];
+
+    diff = (int32_t)(median - filt->ewma_hz);
+    if ((diff > (int32_t)PCLK_FILT_SNAP_HZ) || (diff < -(int32_t)PCLK_FILT_SNAP_HZ))
+        filt->ewma_hz = median;
+    else
+        filt->ewma_hz += diff / (1<<PCLK_FILT_ALPHA_SHIFT);
+
+    return filt->ewma_hz;
+}
+
 int adv761x_get_sync_stats(adv761x_dev *dev) {
-    int mode_changed = 0, dv1_pr = 0, dv1_menu, i;
-    adv761x_sync_status ss = {0};
+    int mode_changed = 0, timing_changed, dv1_pr = 0, dv1_menu, v_valid;
+    adv761x_timing_snapshot snap;
+    adv761x_sync_status ss;
     uint32_t pclk_hz;
     uint8_t pixelderep, pixelderep_ifr, hdmi_mode, ar_idx;
     uint8_t regval;
+    const uint8_t *spd;
     uint16_t de_h, de_v;
-    char dv_id[3], dv_corename[16];
+    char dv_corename[16];
+
+    // keep last status while within dropout grace window
+    if (dev->grace_polls)
+        return 0;
 
-    ss.h_total = ((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_TOTAL_LINE_WIDTH_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_TOTAL_LINE_WIDTH_2);
-    ss.h_synclen = ((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_HSYNC_PULSEWIDTH_1) & 0x1f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_HSYNC_PULSEWIDTH_2);
-    ss.h_backporch = ((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_HSYNC_BACKPORCH_1) & 0x1f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_HSYNC_BACKPORCH_2);
-    ss.h_active = ((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_LINE_WIDTH_1) & 0x1f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_LINE_WIDTH_2);
+    adv761x_read_timing_snapshot(dev, &snap);
+    v_valid = adv761x_decode_sync_status(&snap, &ss);
 
-    // check if NEW_VS_PARAM needs to be set
+    // check if NEW_VS_PARAM needs to be set. V params are remeasured after change, so skip current readout.
     regval = adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_HDMI_REG_4CH);
-    if ((ss.h_total-ss.h_active > ss.h_active) && !(regval & (1<<2)))
+    if ((ss.h_total-ss.h_active > ss.h_active) && !(regval & (1<<2))) {
         adv761x_writereg(dev, ADV761X_HDMI_MAP, ADV761X_HDMI_REG_4CH, (regval | (1<<2)));
-    else if ((ss.h_total-ss.h_active <= ss.h_active) && (regval & (1<<2)))
+        dev->sync_update_pending = 1;
+        return 0;
+    } else if ((ss.h_total-ss.h_active <= ss.h_active) && (regval & (1<<2))) {
         adv761x_writereg(dev, ADV761X_HDMI_MAP, ADV761X_HDMI_REG_4CH, (regval & ~(1<<2)));
-
-    // Check if V params are valid
-    if (!(adv761x_readreg(dev, ADV761X_IO_MAP, ADV761X_HDMI_LVL_RAW_STAT_3) & (1<<1)))
+        dev->sync_update_pending = 1;
         return 0;
+    }
 
-    ss.interlace_flag = !!(adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_HEIGHT_1) & (1<<5));
-
-    if (!ss.interlace_flag) {
-        ss.v_total = (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_TOT_HEIGHT_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_TOT_HEIGHT_2))/2;
-        ss.v_synclen = (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_VS_WIDTH_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_VS_WIDTH_2))/2;
-        ss.v_backporch = (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_VS_BPORCH_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_VS_BPORCH_2))/2;
-        ss.v_active = (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_HEIGHT_1) & 0x1f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_HEIGHT_2));
-    } else {
-        ss.v_total = ((((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_TOT_HEIGHT_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_TOT_HEIGHT_2)) +
-                      (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_TOT_HEIGHT_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_TOT_HEIGHT_2)))/2;
-        ss.v_synclen = ((((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_VS_WIDTH_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_VS_WIDTH_2)) +
-                        (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_VS_WIDTH_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_VS_WIDTH_2)))/4;
-        ss.v_backporch = ((((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_VS_BPORCH_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_VS_BPORCH_2)) +
-                          (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_VS_BPORCH_1) & 0x3f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_VS_BPORCH_2)))/4;
-        ss.v_active = ((((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_HEIGHT_1) & 0x1f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD0_HEIGHT_2)) +
-                       (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_HEIGHT_1) & 0x1f) << 8) | adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_HEIGHT_2)))/2;
+    if (!v_valid) {
+        dev->sync_update_pending = 1;
+        return 0;
     }
 
-    regval = adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_HDMI_REG_05H);
-    ss.h_polarity = !!(regval & (1<<5));
-    ss.v_polarity = !!(regval & (1<<4));
+    regval = ADV761X_SNAP_REG(&snap, ADV761X_HDMI_REG_05H);
     hdmi_mode = regval >> 7;
 
     pixelderep = regval & 0xf;
     if (hdmi_mode) {
-        pixelderep_ifr = adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_AVI_INFOFRAME_DB5) & 0xf;
-        ar_idx = (adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_AVI_INFOFRAME_DB2) >> 4) & 0x3;
+        adv761x_poll_infoframes(dev);
+        pixelderep_ifr = dev->ifr.avi[5] & 0xf;
+        ar_idx = (dev->ifr.avi[2] >> 4) & 0x3;
     } else {
         pixelderep_ifr = 0;
         ar_idx = 0;
     }
 
     if (hdmi_mode && dev->cfg.enable_dv1) {
-        dv_id[0] = adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1);
-        dv_id[1] = adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+1);
-        dv_id[2] = adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+2);
+        spd = dev->ifr.spd;
 
-        if (strncmp(dv_id, "DV1", 3) == 0) {
+        if (strncmp((const char*)&spd[1], "DV1", 3) == 0) {
             dv1_pr = 1;
-            dv1_menu = !!(adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+3) & 0x4);
-            pixelderep_ifr = adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+4)-1;
+            dv1_menu = !!(spd[4] & 0x4);
+            pixelderep_ifr = spd[5]-1;
 
-            de_v = (adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+8) << 8) | adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+7);
-            ss.v_active = ((adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+12) << 8) | adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+11)) >> ss.interlace_flag;
-            de_h = (adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+6) << 8) | adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+5);
-            ss.h_active = (pixelderep_ifr+1)*((adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+10) << 8) | adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+9));
+            de_v = (spd[9] << 8) | spd[8];
+            ss.v_active = ((spd[13] << 8) | spd[12]) >> ss.interlace_flag;
+            de_h = (spd[7] << 8) | spd[6];
+            ss.h_active = (pixelderep_ifr+1)*((spd[11] << 8) | spd[10]);
 
             if (dv1_menu && dev->cfg.enable_dv1_menu && (ss.h_active/(pixelderep_ifr+1) < 640))
                 pixelderep_ifr /= (640/(ss.h_active/(pixelderep_ifr+1)))+1;
@@ -355,8 +788,7 @@ int adv761x_get_sync_stats(adv761x_dev *dev) {
                 ss.v_backporch = de_v ? de_v - 1 : 0; // fix vertical offset with most cores
             }
 
-            for (i=0; i<15; i++)
-                dv_corename[i] = adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_SPD_INFOFRAME_DB1+13+i);
+            memcpy(dv_corename, &spd[14], 15);
             dv_corename[15] = 0;
 
             // SNES 240p adjust (-8 clocks every other fframe)
@@ -365,15 +797,15 @@ int adv761x_get_sync_stats(adv761x_dev *dev) {
         }
     }
 
-    regval = adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_TMDSFREQ_2);
-    pclk_hz = (((adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_TMDSFREQ_1) << 1) | (regval >> 7))*1000000 + ((1000000*(regval & 0x7f)) / 128)) / (pixelderep + 1);
+    regval = snap.tmdsfreq[1];
+    pclk_hz = (((snap.tmdsfreq[0] << 1) | (regval >> 7))*1000000 + ((1000000*(regval & 0x7f)) / 128)) / (pixelderep + 1);
 #ifdef SPOOF_XTAL_FREQ
     pclk_hz = (9*pclk_hz)/8;
 #endif
 
     // check if input is deepcolor
     if (hdmi_mode) {
-        regval = adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_FIELD1_HEIGHT_1) >> 6;
+        regval = ADV761X_SNAP_REG(&snap, ADV761X_FIELD1_HEIGHT_1) >> 6;
         if (regval == 1)
             pclk_hz = (pclk_hz*4)/5;
         else if (regval == 2)
@@ -388,20 +820,38 @@ int adv761x_get_sync_stats(adv761x_dev *dev) {
             adv761x_set_pixelderep(dev, 0);
     }
 
-    if (memcmp(&ss, &dev->ss, sizeof(adv761x_sync_status)) ||
+    dev->pclk_hz_inst = pclk_hz;
+
+    timing_changed = memcmp(&ss, &dev->ss, sizeof(adv761x_sync_status)) ||
+                     (pixelderep != dev->pixelderep) ||
+                     (pixelderep_ifr != dev->pixelderep_ifr) ||
+                     (hdmi_mode != dev->hdmi_mode);
+
+    // Restart pclk filter on timing change so that new mode is reported without filter delay
+    if (timing_changed || (dev->pclk_filt.num == 0))
+        adv761x_pclk_filter_reset(&dev->pclk_filt, pclk_hz);
+    else
+        pclk_hz = adv761x_pclk_filter_update(&dev->pclk_filt, pclk_hz);
+
+    if (timing_changed ||
         (pclk_hz < (dev->pclk_hz - PCLK_HZ_TOLERANCE)) ||
         (pclk_hz > (dev->pclk_hz + PCLK_HZ_TOLERANCE)) ||
-        (pixelderep != dev->pixelderep) ||
-        (pixelderep_ifr != dev->pixelderep_ifr) ||
-        (hdmi_mode != dev->hdmi_mode) ||
         (ar_idx != dev->ar_idx))
     {
         mode_changed = 1;
 
-        if (pclk_hz <= 100000000UL)
-            adv761x_writereg(dev, ADV761X_IO_MAP, ADV761X_IO_REG_14, 0x6a);
+        // Apply hysteresis around threshold to avoid toggling with sources close to it
+        if (dev->io_reg_14 == 0x6e)
+            regval = (pclk_hz < PCLK_IO14_THOLD_HZ-PCLK_IO14_HYST_HZ) ? 0x6a : 0x6e;
+        else if (dev->io_reg_14 == 0x6a)
+            regval = (pclk_hz > PCLK_IO14_THOLD_HZ+PCLK_IO14_HYST_HZ) ? 0x6e : 0x6a;
         else
-            adv761x_writereg(dev, ADV761X_IO_MAP, ADV761X_IO_REG_14, 0x6e);
+            regval = (pclk_hz <= PCLK_IO14_THOLD_HZ) ? 0x6a : 0x6e;
+
+        if (regval != dev->io_reg_14) {
+            adv761x_writereg(dev, ADV761X_IO_MAP, ADV761X_IO_REG_14, regval);
+            dev->io_reg_14 = regval;
+        }
 
         printf("advrx h_total: %u\n", ss.h_total);
         printf("advrx h_synclen: %u\n", ss.h_synclen);
@@ -413,22 +863,69 @@ int adv761x_get_sync_stats(adv761x_dev *dev) {
         printf("advrx v_active: %u\n", ss.v_active);
         printf("advrx sync polarities: H(%c) V(%c)\n", (ss.h_polarity ? '+' : '-'), (ss.v_polarity ? '+' : '-'));
         printf("advrx interlace_flag: %u\n", ss.interlace_flag);
-        printf("advrx pclk: %luHz\n", pclk_hz);
+        printf("advrx pclk: %luHz (inst. %luHz)\n", pclk_hz, dev->pclk_hz_inst);
         printf("advrx pixelderep: %u (IFR: %u)\n", pixelderep, pixelderep_ifr);
         printf("advrx hdmi_mode: %u%s%s\n", hdmi_mode, dv1_pr ? ", DV1: " : "", dv1_pr ? dv_corename : "");
         printf("advrx ar_idx: %u\n", ar_idx);
+    } else if (dev->resume_check) {
+        dev->stats.reconfigs_avoided++;
+        printf("advrx resumed after dropout\n");
     }
+    dev->resume_check = 0;
 
     memcpy(&dev->ss, &ss, sizeof(adv761x_sync_status));
-    dev->pclk_hz = pclk_hz;
+    if (mode_changed)
+        dev->pclk_hz = pclk_hz;
     dev->pixelderep = pixelderep;
     dev->pixelderep_ifr = pixelderep_ifr;
     dev->hdmi_mode = hdmi_mode;
     dev->ar_idx = ar_idx;
+    dev->sync_update_pending = 0;
 
     return mode_changed;
 }
 
+// Read channel status and audio infoframe in two bursts. Returns mask of adv761x_audio_change since previous call.
+// Audio infoframe goes through the infoframe cache, so its changes are still reported by adv761x_update_infoframes().
+uint8_t adv761x_get_audio_status(adv761x_dev *dev, adv761x_audio_status *as) {
+    adv761x_audio_status cur;
+    uint8_t changed = 0;
+
+    adv761x_readregs(dev, ADV761X_HDMI_MAP, ADV761X_IEC60958_DATA_1, cur.cs, sizeof(cur.cs));
+    adv761x_refresh_infoframes(dev, (1<<ADV761X_IFR_AUDIO), (1<<ADV761X_IFR_AUDIO));
+
+    cur.sample_type = !!(cur.cs[ADV761X_IEC60958_DATA_1-ADV761X_IEC60958_DATA_1] & (1<<1));
+    cur.i2s_fs = cur.cs[ADV761X_IEC60958_DATA_4-ADV761X_IEC60958_DATA_1] & 0xf;
+    cur.cc = dev->ifr.audio[1] & 0x7;
+    cur.ca = dev->ifr.audio[4];
+
+    if (!dev->audio_valid || (cur.sample_type != dev->audio.sample_type))
+        changed |= ADV761X_AUDIO_CHG_SAMPLE_TYPE;
+    if (!dev->audio_valid || (cur.i2s_fs != dev->audio.i2s_fs))
+        changed |= ADV761X_AUDIO_CHG_FS;
+    if (!dev->audio_valid || (cur.cc != dev->audio.cc))
+        changed |= ADV761X_AUDIO_CHG_CC;
+    if (!dev->audio_valid || (cur.ca != dev->audio.ca))
+        changed |= ADV761X_AUDIO_CHG_CA;
+    if (!dev->audio_valid || memcmp(cur.cs, dev->audio.cs, sizeof(cur.cs)))
+        changed |= ADV761X_AUDIO_CHG_CS;
+
+    // S/PDIF mux follows sample type
+    if (cur.sample_type != dev->audio_sample_type) {
+        adv761x_set_spdif_mux(dev, (cur.sample_type == IEC60958_SAMPLE_NONPCM));
+        dev->audio_sample_type = cur.sample_type;
+    }
+
+    memcpy(&dev->audio, &cur, sizeof(adv761x_audio_status));
+    dev->audio_valid = 1;
+    dev->audio_polled = 1;
+
+    if (as)
+        memcpy(as, &cur, sizeof(adv761x_audio_status));
+
+    return changed;
+}
+
 HDMI_audio_sample_type_t adv761x_get_audio_sample_type(adv761x_dev *dev) {
     return !!(adv761x_readreg(dev, ADV761X_HDMI_MAP, ADV761X_IEC60958_DATA_1) & (1<<1));
 }
@@ -438,26 +935,38 @@ HDMI_i2s_fs_t adv761x_get_i2s_fs(adv761x_dev *dev) {
 }
 
 HDMI_audio_cc_t adv761x_get_audio_cc(adv761x_dev *dev) {
-    return (adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_AUD_INFOFRAME_DB1) & 0x7);
+    if (!(dev->ifr.valid & (1<<ADV761X_IFR_AUDIO)))
+        adv761x_poll_infoframes(dev);
+
+    return (dev->ifr.audio[1] & 0x7);
 }
 
 HDMI_audio_ca_t adv761x_get_audio_ca(adv761x_dev *dev) {
-    return adv761x_readreg(dev, ADV761X_INFOFRAME_MAP, ADV761X_AUD_INFOFRAME_DB4);
+    if (!(dev->ifr.valid & (1<<ADV761X_IFR_AUDIO)))
+        adv761x_poll_infoframes(dev);
+
+    return dev->ifr.audio[4];
 }
 
 void adv761x_update_config(adv761x_dev *dev, adv761x_config *cfg) {
-    HDMI_audio_sample_type_t audio_sample_type = adv761x_get_audio_sample_type(dev);
+    HDMI_audio_sample_type_t audio_sample_type;
+
+    // Keep S/PDIF mux following sample type with a single register read if firmware does not poll adv761x_get_audio_status()
+    if (!dev->audio_polled) {
+        audio_sample_type = adv761x_get_audio_sample_type(dev);
+        if (audio_sample_type != dev->audio_sample_type) {
+            adv761x_set_spdif_mux(dev, (audio_sample_type == IEC60958_SAMPLE_NONPCM));
+            dev->audio_sample_type = audio_sample_type;
+        }
+    }
+    dev->audio_polled = 0;
 
     if (cfg->default_rgb_range != dev->cfg.default_rgb_range)
         adv761x_set_default_rgb_range(dev, cfg->default_rgb_range);
     if (cfg->pixelderep_mode != dev->cfg.pixelderep_mode)
         adv761x_set_pixelderep(dev, cfg->pixelderep_mode);
     if (cfg->edid_sel != dev->cfg.edid_sel)
-        adv761x_update_edid(dev, cfg->edid_sel);
-    if (audio_sample_type != dev->audio_sample_type) {
-        adv761x_set_spdif_mux(dev, (audio_sample_type == IEC60958_SAMPLE_NONPCM));
-        dev->audio_sample_type = audio_sample_type;
-    }
+        adv761x_edid_switch_start(dev, cfg->edid_sel);
 
     memcpy(&dev->cfg, cfg, sizeof(adv761x_config));
 }
@@ -57,14 +57,94 @@ typedef struct {
     int8_t f_pix_adder;
 } adv761x_sync_status;
 
+// Raw HDMI map timing registers, read in bursts
+typedef struct {
+    uint8_t raw_stat_3;
+    uint8_t hdmi[ADV761X_FIELD1_VS_BPORCH_2-ADV761X_HDMI_REG_05H+1];
+    uint8_t tmdsfreq[2];
+} adv761x_timing_snapshot;
+
+#define ADV761X_SNAP_REG(snap, regaddr) ((snap)->hdmi[(regaddr)-ADV761X_HDMI_REG_05H])
+
+typedef enum {
+    ADV761X_IFR_AVI = 0,
+    ADV761X_IFR_AUDIO,
+    ADV761X_IFR_SPD,
+    ADV761X_IFR_NUM
+} adv761x_infoframe;
+
+// Infoframe packets as PB0 (checksum) followed by data bytes, i.e. index n = DBn
+typedef struct {
+    uint8_t avi[14];
+    uint8_t audio[11];
+    uint8_t spd[29];
+    uint8_t valid;
+    uint8_t changed;        // packets changed since last adv761x_update_infoframes() call
+} adv761x_infoframe_cache;
+
+typedef enum {
+    ADV761X_EV_TMDS_CLK         = (1<<0),
+    ADV761X_EV_DE_REGEN_LCK     = (1<<1),
+    ADV761X_EV_V_LOCKED         = (1<<2),
+    ADV761X_EV_NEW_AVI_IFR      = (1<<3),
+    ADV761X_EV_NEW_AUDIO_IFR    = (1<<4),
+    ADV761X_EV_NEW_SPD_IFR      = (1<<5),
+    ADV761X_EV_AUDIO_FS_CHANGE  = (1<<6),
+    ADV761X_EV_CABLE_DET        = (1<<7),
+    // Generated by driver after servicing status
+    ADV761X_EV_ACTIVITY_CHANGE  = (1<<8),
+    ADV761X_EV_MODE_CHANGE      = (1<<9),
+    ADV761X_EV_RESUMED          = (1<<10),
+} adv761x_event;
+
+#define ADV761X_EV_HW_MASK          0xff
+#define ADV761X_EV_LOCK_MASK        (ADV761X_EV_TMDS_CLK|ADV761X_EV_DE_REGEN_LCK|ADV761X_EV_V_LOCKED)
+
+typedef enum {
+    ADV761X_EDID_IDLE = 0,
+    ADV761X_EDID_RESET_WAIT,
+    ADV761X_EDID_UPLOAD,
+} adv761x_edid_state;
+
+typedef struct {
+    uint8_t cs[ADV761X_IEC60958_DATA_5-ADV761X_IEC60958_DATA_1+1];  // raw IEC60958 channel status
+    HDMI_audio_sample_type_t sample_type;
+    HDMI_i2s_fs_t i2s_fs;
+    HDMI_audio_cc_t cc;
+    HDMI_audio_ca_t ca;
+} adv761x_audio_status;
+
+typedef enum {
+    ADV761X_AUDIO_CHG_SAMPLE_TYPE   = (1<<0),
+    ADV761X_AUDIO_CHG_FS            = (1<<1),
+    ADV761X_AUDIO_CHG_CC            = (1<<2),
+    ADV761X_AUDIO_CHG_CA            = (1<<3),
+    ADV761X_AUDIO_CHG_CS            = (1<<4),
+} adv761x_audio_change;
+
 typedef struct {
     adv761x_rgb_range default_rgb_range;
     uint8_t pixelderep_mode;
     uint8_t enable_dv1;
     uint8_t enable_dv1_menu;
     uint8_t edid_sel;
+    uint8_t dropout_grace_polls;
 } adv761x_config;
 
+#define ADV761X_PCLK_MEDIAN_N       5
+
+typedef struct {
+    uint32_t samples[ADV761X_PCLK_MEDIAN_N];
+    uint8_t idx;
+    uint8_t num;
+    uint32_t ewma_hz;
+} adv761x_pclk_filter;
+
+typedef struct {
+    uint32_t dropouts;
+    uint32_t reconfigs_avoided;
+} adv761x_stats;
+
 typedef struct {
     uint32_t i2cm_base;
     uint8_t io_base;
@@ -77,15 +157,35 @@ typedef struct {
     uint8_t cp_base;
     uint32_t xtal_freq;
     const edid_t **edid_list;
+    uint32_t (*get_ms)(void);   // optional ms time base, needed for non-blocking EDID switch
+    uint32_t sw_ms;             // time base advanced by blocking calls when get_ms is not set
+    uint8_t edid_shadow[EDID_MAX_SIZE];
+    unsigned edid_shadow_len;
+    adv761x_edid_state edid_state;
+    unsigned edid_target;
+    unsigned edid_offset;
+    uint32_t edid_reset_ms;
     uint8_t sync_active;
     adv761x_sync_status ss;
-    uint32_t pclk_hz;
+    uint32_t pclk_hz;       // stable value, updated on mode change
+    uint32_t pclk_hz_inst;  // latest TMDSFREQ sample
+    adv761x_pclk_filter pclk_filt;
+    uint8_t io_reg_14;
     uint8_t pixelderep;
     uint8_t pixelderep_ifr;
     uint8_t hdmi_mode;
     uint8_t ar_idx;
     uint8_t powered_on;
     HDMI_audio_sample_type_t audio_sample_type;
+    adv761x_audio_status audio;
+    uint8_t audio_valid;
+    uint8_t audio_polled;   // adv761x_get_audio_status() called since last adv761x_update_config()
+    adv761x_infoframe_cache ifr;
+    uint16_t irq_mask;
+    uint8_t sync_update_pending;
+    uint8_t grace_polls;
+    uint8_t resume_check;
+    adv761x_stats stats;
     adv761x_config cfg;
 } adv761x_dev;
 
@@ -95,6 +195,10 @@ void adv761x_get_default_cfg(adv761x_config *cfg);
 
 void adv761x_enable_power(adv761x_dev *dev, int enable);
 
+int adv761x_edid_switch_start(adv761x_dev *dev, unsigned edid_id);
+
+adv761x_edid_state adv761x_edid_switch_poll(adv761x_dev *dev);
+
 int adv761x_update_edid(adv761x_dev *dev, unsigned edid_id);
 
 void adv761x_set_default_rgb_range(adv761x_dev *dev, adv761x_rgb_range rng);
@@ -107,8 +211,22 @@ void adv761x_set_input_cs(adv761x_dev *dev);
 
 int adv761x_check_activity(adv761x_dev *dev);
 
+void adv761x_enable_irq(adv761x_dev *dev, uint16_t ev_mask);
+
+uint16_t adv761x_service_irq(adv761x_dev *dev);
+
+int adv761x_poll_required(adv761x_dev *dev);
+
+void adv761x_read_timing_snapshot(adv761x_dev *dev, adv761x_timing_snapshot *snap);
+
+int adv761x_decode_sync_status(const adv761x_timing_snapshot *snap, adv761x_sync_status *ss);
+
+uint8_t adv761x_update_infoframes(adv761x_dev *dev);
+
 int adv761x_get_sync_stats(adv761x_dev *dev);
 
+uint8_t adv761x_get_audio_status(adv761x_dev *dev, adv761x_audio_status *as);
+
 HDMI_audio_sample_type_t adv761x_get_audio_sample_type(adv761x_dev *dev);
 
 HDMI_i2s_fs_t adv761x_get_i2s_fs(adv761x_dev *dev);
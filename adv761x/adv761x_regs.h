@@ -34,7 +34,21 @@
 #define ADV761X_HPA_REG1            0x20
 #define ADV761X_HPA_REG2            0x21
 #define ADV761X_IO_REG_33           0x33
+#define ADV761X_IO_REG_40           0x40
 #define ADV761X_HDMI_LVL_RAW_STAT_3 0x6A
+#define ADV761X_HDMI_LVL_INT_ST_3   0x6B
+#define ADV761X_HDMI_LVL_INT_CLR_3  0x6C
+#define ADV761X_HDMI_LVL_INT_MASK_3 0x6E
+#define ADV761X_HDMI_LVL_RAW_STAT_4 0x6F
+#define ADV761X_HDMI_LVL_INT_ST_4   0x70
+#define ADV761X_HDMI_LVL_INT_CLR_4  0x71
+#define ADV761X_HDMI_LVL_INT_MASK_4 0x73
+#define ADV761X_NEW_IFR_INT_ST      0x7A
+#define ADV761X_NEW_IFR_INT_CLR     0x7B
+#define ADV761X_NEW_IFR_INT_MASK    0x7D
+#define ADV761X_AUDIO_INT_ST        0x84
+#define ADV761X_AUDIO_INT_CLR       0x85
+#define ADV761X_AUDIO_INT_MASK      0x87
 #define ADV761X_CEC_SLAVEADDR       0xF4
 #define ADV761X_INFRM_SLAVEADDR     0xF5
 #define ADV761X_DPLL_SLAVEADDR      0xF8
@@ -91,15 +105,18 @@
 #define ADV761X_HDMI_REGISTER_02H   0x83
 
 // Infoframe map
+#define ADV761X_AVI_INFOFRAME_PB0   0x00
 #define ADV761X_AVI_INFOFRAME_DB1   0x01
 #define ADV761X_AVI_INFOFRAME_DB2   0x02
 #define ADV761X_AVI_INFOFRAME_DB3   0x03
 #define ADV761X_AVI_INFOFRAME_DB4   0x04
 #define ADV761X_AVI_INFOFRAME_DB5   0x05
+#define ADV761X_AUD_INFOFRAME_PB0   0x1C
 #define ADV761X_AUD_INFOFRAME_DB1   0x1D
 #define ADV761X_AUD_INFOFRAME_DB2   0x1E
 #define ADV761X_AUD_INFOFRAME_DB3   0x1F
 #define ADV761X_AUD_INFOFRAME_DB4   0x20
+#define ADV761X_SPD_INFOFRAME_PB0   0x2A
 #define ADV761X_SPD_INFOFRAME_DB1   0x2B
 
 #endif /* ADV761X_REGS_H_ */
@@ -0,0 +1,40 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdint.h>
+#include "mode_table.h"
+
+const isl51002_frontend_setup* mode_table_get_fe(int mode_id) {
+    if ((mode_id < 0) || (mode_id >= mode_table_size))
+        return NULL;
+
+    return &mode_table[mode_id].fe;
+}
+
+// Returns NULL if entry does not exist or is not valid, in which case caller falls back to runtime calculation
+const mode_table_out_t* mode_table_get_out(int mode_id, uint8_t mult) {
+    const mode_table_out_t *out;
+
+    if ((mode_id < 0) || (mode_id >= mode_table_size) || (mult == 0) || (mult > MODE_TABLE_MAX_MULT))
+        return NULL;
+
+    out = &mode_table[mode_id].out[mult-1];
+
+    return out->valid ? out : NULL;
+}
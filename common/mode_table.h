@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef MODE_TABLE_H_
+#define MODE_TABLE_H_
+
+#include <stdint.h>
+#include "si5351.h"
+#include "isl51002.h"
+
+// Precalculated mode-switch parameters per vmode_class catalogue mode, generated offline by
+// tools/modegen into a firmware source file defining mode_table[] and mode_table_size. The
+// table must be regenerated whenever the catalogue or the solver/mapping code changes.
+//
+// For a mode as analog input, fe holds isl_calc_frontend_setup() result (default config,
+// tri-level sync for HD CEA modes) for isl_apply_frontend_setup(). For line multiplier
+// 1..MODE_TABLE_MAX_MULT, out[] holds Si5351 config for CLKIN = mode pixel clock and
+// ratio mult/1 (for si5351_set_frac_mult() ms_conf), and VIC / pixel repetition of the
+// resulting output timing.
+
+#define MODE_TABLE_MAX_MULT     5
+
+typedef struct {
+    uint8_t valid;              // 0 if output exceeds Si5351 range or no config was found
+    uint8_t vic;                // HDMI_vic_t for 4:3 (or only) aspect, HDMI_Unknown if not CEA
+    uint8_t vic_16x9;           // HDMI_vic_t for 16:9, HDMI_Unknown if none
+    uint8_t pixelrep_ifr;
+    int32_t err_ppb;
+    si5351_ms_config_t ms_conf;
+} mode_table_out_t;
+
+typedef struct {
+    isl51002_frontend_setup fe;
+    mode_table_out_t out[MODE_TABLE_MAX_MULT];
+} mode_table_entry_t;
+
+extern const mode_table_entry_t mode_table[];
+extern const int mode_table_size;
+
+const isl51002_frontend_setup* mode_table_get_fe(int mode_id);
+
+const mode_table_out_t* mode_table_get_out(int mode_id, uint8_t mult);
+
+#endif /* MODE_TABLE_H_ */
@@ -0,0 +1,170 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "regq.h"
+#include "i2c_opencores.h"
+
+void regq_init(regq_t *q) {
+    memset(q, 0, sizeof(regq_t));
+}
+
+// Drop pending write set, e.g. when the same registers are written immediately during mode change
+void regq_cancel(regq_t *q, uint32_t i2cm_base, uint8_t owner_addr, uint8_t tag) {
+    int i, j = 0;
+
+    for (i=0; i<q->num_entries; i++) {
+        if ((q->entries[i].i2cm_base == i2cm_base) && (q->entries[i].owner_addr == owner_addr) && (q->entries[i].tag == tag))
+            continue;
+        if (i != j)
+            q->entries[j] = q->entries[i];
+        j++;
+    }
+    q->num_entries = j;
+}
+
+// Drop pending writes to registers [regaddr, regaddr+len) so that a following immediate
+// write to them is not overwritten by stale data on next flush
+void regq_drop(regq_t *q, uint32_t i2cm_base, uint8_t i2c_addr, uint8_t regaddr, uint8_t len) {
+    int i, j = 0;
+
+    for (i=0; i<q->num_entries; i++) {
+        if ((q->entries[i].i2cm_base == i2cm_base) && (q->entries[i].i2c_addr == i2c_addr) && ((uint8_t)(q->entries[i].regaddr-regaddr) < len))
+            continue;
+        if (i != j)
+            q->entries[j] = q->entries[i];
+        j++;
+    }
+    q->num_entries = j;
+}
+
+void regq_begin(regq_t *q, uint32_t i2cm_base, uint8_t owner_addr, uint8_t tag) {
+    int num_entries = q->num_entries;
+
+    // Drop pending write set with same id
+    regq_cancel(q, i2cm_base, owner_addr, tag);
+    if (q->num_entries != num_entries)
+        q->sets_coalesced++;
+
+    q->cur_i2cm_base = i2cm_base;
+    q->cur_owner_addr = owner_addr;
+    q->cur_tag = tag;
+    q->cur_overflow = 0;
+}
+
+// Write out already queued part of current set immediately and remove it from queue
+static void regq_flush_current(regq_t *q) {
+    regq_entry_t *e;
+    int i, j = 0;
+
+    for (i=0; i<q->num_entries; i++) {
+        e = &q->entries[i];
+
+        if ((e->i2cm_base == q->cur_i2cm_base) && (e->owner_addr == q->cur_owner_addr) && (e->tag == q->cur_tag)) {
+            I2C_start(e->i2cm_base, e->i2c_addr, 0);
+            I2C_write(e->i2cm_base, e->regaddr, 0);
+            I2C_write(e->i2cm_base, e->data, 1);
+            continue;
+        }
+        if (i != j)
+            q->entries[j] = q->entries[i];
+        j++;
+    }
+    q->num_entries = j;
+}
+
+// Queue register write to current set. Returns -1 if queue is full, in which case the whole
+// current set is written immediately: the part queued so far is written out here and caller
+// must write this and following registers of the set immediately. Other pending sets are
+// kept for next flush, so they are never split across frames.
+int regq_write(regq_t *q, uint32_t i2cm_base, uint8_t i2c_addr, uint8_t regaddr, uint8_t data) {
+    regq_entry_t *e;
+
+    if (q->cur_overflow)
+        return -1;
+
+    if (q->num_entries == REGQ_MAX_ENTRIES) {
+        regq_flush_current(q);
+        q->cur_overflow = 1;
+        q->forced_flushes++;
+        return -1;
+    }
+
+    e = &q->entries[q->num_entries++];
+    e->i2cm_base = i2cm_base;
+    e->owner_addr = q->cur_owner_addr;
+    e->tag = q->cur_tag;
+    e->i2c_addr = i2c_addr;
+    e->regaddr = regaddr;
+    e->data = data;
+
+    return 0;
+}
+
+// Get value a register will have once queue is flushed. Returns 0 if register has no pending writes.
+int regq_read_pending(regq_t *q, uint32_t i2cm_base, uint8_t i2c_addr, uint8_t regaddr, uint8_t *data) {
+    int i;
+
+    for (i=q->num_entries-1; i>=0; i--) {
+        if ((q->entries[i].i2cm_base == i2cm_base) && (q->entries[i].i2c_addr == i2c_addr) && (q->entries[i].regaddr == regaddr)) {
+            *data = q->entries[i].data;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int regq_pending(regq_t *q) {
+    return q->num_entries;
+}
+
+// Write out queued registers, merging consecutive addresses into auto-increment bursts.
+// Returns number of I2C transactions issued.
+int regq_flush(regq_t *q) {
+    regq_entry_t *e;
+    int i, last, num_xfers = 0;
+
+    for (i=0; i<q->num_entries; i++) {
+        e = &q->entries[i];
+
+        if ((i == 0) ||
+            (e->i2cm_base != q->entries[i-1].i2cm_base) ||
+            (e->i2c_addr != q->entries[i-1].i2c_addr) ||
+            (e->regaddr != (uint8_t)(q->entries[i-1].regaddr+1)))
+        {
+            I2C_start(e->i2cm_base, e->i2c_addr, 0);
+            I2C_write(e->i2cm_base, e->regaddr, 0);
+            num_xfers++;
+        }
+
+        last = (i == q->num_entries-1) ||
+               (q->entries[i+1].i2cm_base != e->i2cm_base) ||
+               (q->entries[i+1].i2c_addr != e->i2c_addr) ||
+               (q->entries[i+1].regaddr != (uint8_t)(e->regaddr+1));
+
+        I2C_write(e->i2cm_base, e->data, last);
+    }
+
+    q->num_entries = 0;
+
+    return num_xfers;
+}
@@ -0,0 +1,78 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef REGQ_H_
+#define REGQ_H_
+
+#include <stdint.h>
+
+// Deferred register write queue. Drivers with a queue attached collect glitch-prone
+// writes here and firmware flushes them during vertical blank. Each driver operation
+// forms a write set identified by (i2cm_base, owner address, tag); starting a new set
+// with the same id drops the pending one so that repeated updates within a frame
+// coalesce into a single write set. Drivers call regq_drop() before writing a register
+// immediately so that a pending deferred write cannot later overwrite the new value.
+// If the queue runs full, the set being written falls back to immediate writes as a whole
+// (regq_write() returns -1) while sets already queued still wait for the flush.
+//
+// regq_flush() uses the I2C master directly and therefore must not be called from an
+// interrupt context if the bus is shared with main loop. Typical usage is to latch a
+// flag in vsync IRQ (or poll FPGA line counter) and call regq_flush() from main loop.
+
+#ifndef REGQ_MAX_ENTRIES
+#define REGQ_MAX_ENTRIES 96
+#endif
+
+typedef struct {
+    uint32_t i2cm_base;
+    uint8_t owner_addr;
+    uint8_t tag;
+    uint8_t i2c_addr;
+    uint8_t regaddr;
+    uint8_t data;
+} regq_entry_t;
+
+typedef struct {
+    regq_entry_t entries[REGQ_MAX_ENTRIES];
+    uint16_t num_entries;
+    uint32_t cur_i2cm_base;
+    uint8_t cur_owner_addr;
+    uint8_t cur_tag;
+    uint8_t cur_overflow;
+    uint32_t sets_coalesced;
+    uint32_t forced_flushes;    // sets written immediately because queue was full
+} regq_t;
+
+void regq_init(regq_t *q);
+
+void regq_begin(regq_t *q, uint32_t i2cm_base, uint8_t owner_addr, uint8_t tag);
+
+void regq_cancel(regq_t *q, uint32_t i2cm_base, uint8_t owner_addr, uint8_t tag);
+
+void regq_drop(regq_t *q, uint32_t i2cm_base, uint8_t i2c_addr, uint8_t regaddr, uint8_t len);
+
+int regq_write(regq_t *q, uint32_t i2cm_base, uint8_t i2c_addr, uint8_t regaddr, uint8_t data);
+
+int regq_read_pending(regq_t *q, uint32_t i2cm_base, uint8_t i2c_addr, uint8_t regaddr, uint8_t *data);
+
+int regq_pending(regq_t *q);
+
+int regq_flush(regq_t *q);
+
+#endif /* REGQ_H_ */
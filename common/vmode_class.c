@@ -0,0 +1,251 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "vmode_class.h"
+
+// Must be power of two and at least twice the catalogue size
+#define VMODE_HASH_SLOTS 128
+
+static const vmode_timing_t vmode_catalogue[] = {
+    // name                 std             id    16:9 PR  I  h_act v_act h_tot v_tot pclk_hz
+    {"640x480p60",          VMODE_STD_CEA,  1,    0,   0,  0, 640,  480,  800,  525,  25175000},
+    {"720x480p60",          VMODE_STD_CEA,  2,    3,   0,  0, 720,  480,  858,  525,  27000000},
+    {"1280x720p60",         VMODE_STD_CEA,  4,    0,   0,  0, 1280, 720,  1650, 750,  74250000},
+    {"1920x1080i60",        VMODE_STD_CEA,  5,    0,   0,  1, 1920, 540,  2200, 1125, 74250000},
+    {"720(1440)x480i60",    VMODE_STD_CEA,  6,    7,   1,  1, 1440, 240,  1716, 525,  27000000},
+    {"720(1440)x240p60",    VMODE_STD_CEA,  8,    9,   1,  0, 1440, 240,  1716, 262,  27000000},
+    {"(2880)x240p60",       VMODE_STD_CEA,  12,   13,  3,  0, 2880, 240,  3432, 262,  54000000},
+    {"1440x480p60",         VMODE_STD_CEA,  14,   15,  0,  0, 1440, 480,  1716, 525,  54000000},
+    {"1920x1080p60",        VMODE_STD_CEA,  16,   0,   0,  0, 1920, 1080, 2200, 1125, 148500000},
+    {"720x576p50",          VMODE_STD_CEA,  17,   18,  0,  0, 720,  576,  864,  625,  27000000},
+    {"1280x720p50",         VMODE_STD_CEA,  19,   0,   0,  0, 1280, 720,  1980, 750,  74250000},
+    {"1920x1080i50",        VMODE_STD_CEA,  20,   0,   0,  1, 1920, 540,  2640, 1125, 74250000},
+    {"720(1440)x576i50",    VMODE_STD_CEA,  21,   22,  1,  1, 1440, 288,  1728, 625,  27000000},
+    {"720(1440)x288p50",    VMODE_STD_CEA,  23,   24,  1,  0, 1440, 288,  1728, 312,  27000000},
+    {"(2880)x288p50",       VMODE_STD_CEA,  27,   28,  3,  0, 2880, 288,  3456, 312,  54000000},
+    {"1440x576p50",         VMODE_STD_CEA,  29,   30,  0,  0, 1440, 576,  1728, 625,  54000000},
+    {"1920x1080p50",        VMODE_STD_CEA,  31,   0,   0,  0, 1920, 1080, 2640, 1125, 148500000},
+    {"1920x1080p24",        VMODE_STD_CEA,  32,   0,   0,  0, 1920, 1080, 2750, 1125, 74250000},
+    {"1920x1080p25",        VMODE_STD_CEA,  33,   0,   0,  0, 1920, 1080, 2640, 1125, 74250000},
+    {"1920x1080p30",        VMODE_STD_CEA,  34,   0,   0,  0, 1920, 1080, 2200, 1125, 74250000},
+    {"720x400@85",          VMODE_STD_DMT,  0x03, 0,   0,  0, 720,  400,  936,  446,  35500000},
+    {"800x600@56",          VMODE_STD_DMT,  0x08, 0,   0,  0, 800,  600,  1024, 625,  36000000},
+    {"800x600@60",          VMODE_STD_DMT,  0x09, 0,   0,  0, 800,  600,  1056, 628,  40000000},
+    {"1024x768@60",         VMODE_STD_DMT,  0x10, 0,   0,  0, 1024, 768,  1344, 806,  65000000},
+    {"1024x768@70",         VMODE_STD_DMT,  0x11, 0,   0,  0, 1024, 768,  1328, 806,  75000000},
+    {"1280x800@60",         VMODE_STD_DMT,  0x1C, 0,   0,  0, 1280, 800,  1680, 831,  83500000},
+    {"1280x960@60",         VMODE_STD_DMT,  0x20, 0,   0,  0, 1280, 960,  1800, 1000, 108000000},
+    {"1280x1024@60",        VMODE_STD_DMT,  0x23, 0,   0,  0, 1280, 1024, 1688, 1066, 108000000},
+    {"1360x768@60",         VMODE_STD_DMT,  0x27, 0,   0,  0, 1360, 768,  1792, 795,  85500000},
+    {"1440x900@60",         VMODE_STD_DMT,  0x2F, 0,   0,  0, 1440, 900,  1904, 934,  106500000},
+    {"1600x1200@60",        VMODE_STD_DMT,  0x33, 0,   0,  0, 1600, 1200, 2160, 1250, 162000000},
+    {"1680x1050@60",        VMODE_STD_DMT,  0x3A, 0,   0,  0, 1680, 1050, 2240, 1089, 146250000},
+    {"1920x1200@60RB",      VMODE_STD_DMT,  0x44, 0,   0,  0, 1920, 1200, 2080, 1235, 154000000},
+    {"1366x768@60",         VMODE_STD_DMT,  0x51, 0,   0,  0, 1366, 768,  1792, 798,  85500000},
+    {"1600x900@60RB",       VMODE_STD_DMT,  0x53, 0,   0,  0, 1600, 900,  1800, 1000, 108000000},
+    {"720x400@70",          VMODE_STD_OTHER, 0,   0,   0,  0, 720,  400,  900,  449,  28322000},
+};
+
+#define VMODE_CATALOGUE_SIZE (sizeof(vmode_catalogue)/sizeof(vmode_timing_t))
+
+// Catalogue index+1 per slot, 0 = empty. Built on first use.
+static uint8_t vmode_hash_idx[VMODE_HASH_SLOTS];
+static uint8_t vmode_hash_built;
+
+vmode_class_stats_t vmode_class_stats;
+
+static uint32_t vmode_hash(uint16_t h_total, uint16_t v_total, uint16_t h_active, uint16_t v_active, uint8_t interlace, uint32_t pclk_bucket) {
+    uint32_t h;
+
+    h = (h_total * 0x9E3779B1UL) ^ (v_total * 0x85EBCA77UL);
+    h ^= (h_active * 0xC2B2AE3DUL) ^ (v_active * 0x27D4EB2FUL);
+    h ^= (pclk_bucket * 0x165667B1UL) ^ interlace;
+    h ^= h >> 15;
+
+    return h & (VMODE_HASH_SLOTS-1);
+}
+
+static void vmode_build_hash(void) {
+    const vmode_timing_t *t;
+    uint32_t slot;
+    unsigned i;
+
+    memset(vmode_hash_idx, 0, sizeof(vmode_hash_idx));
+
+    for (i=0; i<VMODE_CATALOGUE_SIZE; i++) {
+        t = &vmode_catalogue[i];
+        slot = vmode_hash(t->h_total, t->v_total, t->h_active, t->v_active, t->interlace, (t->pclk_hz+VMODE_PCLK_BUCKET_HZ/2)/VMODE_PCLK_BUCKET_HZ);
+
+        while (vmode_hash_idx[slot])
+            slot = (slot+1) & (VMODE_HASH_SLOTS-1);
+
+        vmode_hash_idx[slot] = i+1;
+    }
+
+    vmode_hash_built = 1;
+}
+
+static uint32_t vmode_ppm_diff(uint32_t val, uint32_t ref) {
+    uint32_t diff = (val > ref) ? val-ref : ref-val;
+
+    return (uint32_t)(((uint64_t)diff*1000000ULL)/ref);
+}
+
+static int vmode_hash_lookup(const vmode_meas_t *meas) {
+    const vmode_timing_t *t;
+    uint32_t bucket, slot;
+    int b;
+
+    bucket = (meas->pclk_hz+VMODE_PCLK_BUCKET_HZ/2)/VMODE_PCLK_BUCKET_HZ;
+
+    // Check neighbouring buckets too as 1/1.001 rate variants may round differently
+    for (b=-1; b<=1; b++) {
+        if ((int32_t)bucket+b < 0)
+            continue;
+
+        slot = vmode_hash(meas->h_total, meas->v_total, meas->h_active, meas->v_active, meas->interlace, bucket+b);
+
+        while (vmode_hash_idx[slot]) {
+            t = &vmode_catalogue[vmode_hash_idx[slot]-1];
+
+            if ((t->h_total == meas->h_total) &&
+                (t->v_total == meas->v_total) &&
+                (t->h_active == meas->h_active) &&
+                (t->v_active == meas->v_active) &&
+                (t->interlace == meas->interlace) &&
+                (vmode_ppm_diff(meas->pclk_hz, t->pclk_hz) <= VMODE_PCLK_TOL_PPM))
+                return vmode_hash_idx[slot]-1;
+
+            slot = (slot+1) & (VMODE_HASH_SLOTS-1);
+        }
+    }
+
+    return -1;
+}
+
+// Scan catalogue with tolerances, skipping fields that were not measured. Returns closest match.
+static int vmode_fallback_lookup(const vmode_meas_t *meas) {
+    const vmode_timing_t *t;
+    uint32_t score, best_score = 0xffffffff, clk_err;
+    unsigned i;
+    int best = -1, dh, dv;
+
+    for (i=0; i<VMODE_CATALOGUE_SIZE; i++) {
+        t = &vmode_catalogue[i];
+        score = 0;
+
+        if (meas->interlace != t->interlace)
+            continue;
+
+        if (meas->h_total) {
+            dh = meas->h_total - t->h_total;
+            if ((dh < 0 ? -dh : dh) > (t->h_total*VMODE_H_TOL_PCT)/100)
+                continue;
+            score += (dh < 0 ? -dh : dh)*100;
+        }
+        if (meas->h_active) {
+            dh = meas->h_active - t->h_active;
+            if ((dh < 0 ? -dh : dh) > (t->h_active*VMODE_H_TOL_PCT)/100)
+                continue;
+            score += (dh < 0 ? -dh : dh)*100;
+        }
+        if (meas->v_total) {
+            dv = meas->v_total - t->v_total;
+            if ((dv < 0 ? -dv : dv) > VMODE_V_TOL_LINES)
+                continue;
+            score += (dv < 0 ? -dv : dv)*1000;
+        }
+        if (meas->v_active) {
+            dv = meas->v_active - t->v_active;
+            if ((dv < 0 ? -dv : dv) > VMODE_V_TOL_LINES)
+                continue;
+            score += (dv < 0 ? -dv : dv)*1000;
+        }
+
+        if (meas->pclk_hz && meas->h_total) {
+            clk_err = vmode_ppm_diff(meas->pclk_hz, t->pclk_hz);
+            if (clk_err > VMODE_PCLK_TOL_PPM)
+                continue;
+            score += clk_err;
+        } else if (meas->hfreq_hz) {
+            clk_err = vmode_ppm_diff(meas->hfreq_hz, t->pclk_hz/t->h_total);
+            if (clk_err > VMODE_HFREQ_TOL_PPM)
+                continue;
+            score += clk_err;
+        }
+
+        if (score < best_score) {
+            best_score = score;
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+// Returns catalogue mode id, or -1 if timing is not recognized
+int vmode_classify(const vmode_meas_t *meas) {
+    int mode_id = -1;
+
+    if (!vmode_hash_built)
+        vmode_build_hash();
+
+    if (meas->h_total && meas->v_total && meas->h_active && meas->v_active && meas->pclk_hz)
+        mode_id = vmode_hash_lookup(meas);
+
+    if (mode_id >= 0) {
+        vmode_class_stats.hash_hits++;
+        return mode_id;
+    }
+
+    mode_id = vmode_fallback_lookup(meas);
+
+    if (mode_id >= 0)
+        vmode_class_stats.fallback_hits++;
+    else
+        vmode_class_stats.misses++;
+
+    return mode_id;
+}
+
+const vmode_timing_t* vmode_get_timing(int mode_id) {
+    if ((mode_id < 0) || (mode_id >= (int)VMODE_CATALOGUE_SIZE))
+        return NULL;
+
+    return &vmode_catalogue[mode_id];
+}
+
+// VIC to be passed to adv7513_set_pixelrep_vic() / sii1136_init_mode(). DMT and unknown modes map to HDMI_Unknown.
+HDMI_vic_t vmode_get_vic(int mode_id, uint8_t ar_16x9) {
+    const vmode_timing_t *t = vmode_get_timing(mode_id);
+
+    if (!t || (t->std != VMODE_STD_CEA))
+        return HDMI_Unknown;
+
+    return (ar_16x9 && t->id_16x9) ? t->id_16x9 : t->id;
+}
+
+uint8_t vmode_get_pixelrep_ifr(int mode_id) {
+    const vmode_timing_t *t = vmode_get_timing(mode_id);
+
+    return t ? t->pixelrep_ifr : 0;
+}
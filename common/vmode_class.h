@@ -0,0 +1,88 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef VMODE_CLASS_H_
+#define VMODE_CLASS_H_
+
+#include <stdint.h>
+#include "hdmi.h"
+
+// Classifier matching measured sync timing to CEA-861 / VESA DMT catalogue. Measurements
+// from both HDMI receiver (adv761x_sync_status) and analog frontend (isl51002) use the same
+// convention: v_total per frame and v_active per field (i.e. half of frame for interlaced
+// modes), with horizontal values at TMDS link rate (i.e. including pixel repetition). Fields
+// which are not measured on a path are left 0 and ignored.
+//
+// Fully measured timings are looked up from a hash index keyed by
+// (h_total, v_total, h_active, v_active, interlace, pclk bucket). If that fails,
+// catalogue is scanned using tolerances, which also handles partial (analog) measurements.
+
+#define VMODE_PCLK_BUCKET_HZ    1000000UL
+#define VMODE_PCLK_TOL_PPM      5000
+#define VMODE_HFREQ_TOL_PPM     5000
+#define VMODE_H_TOL_PCT         2
+#define VMODE_V_TOL_LINES       2
+
+typedef enum {
+    VMODE_STD_CEA = 0,
+    VMODE_STD_DMT,
+    VMODE_STD_OTHER             // common legacy timing without CEA/DMT ID (id = 0)
+} vmode_std_t;
+
+typedef struct {
+    const char *name;
+    vmode_std_t std;
+    uint8_t id;                 // CEA VIC (4:3 or only aspect) / DMT ID
+    uint8_t id_16x9;            // CEA VIC for 16:9 variant, 0 if none
+    uint8_t pixelrep_ifr;       // AVI infoframe pixel repetition (0 = none, 1 = 2x, 3 = 4x)
+    uint8_t interlace;
+    uint16_t h_active;
+    uint16_t v_active;
+    uint16_t h_total;
+    uint16_t v_total;
+    uint32_t pclk_hz;
+} vmode_timing_t;
+
+typedef struct {
+    uint16_t h_active;
+    uint16_t v_active;
+    uint16_t h_total;
+    uint16_t v_total;
+    uint8_t interlace;
+    uint32_t pclk_hz;
+    uint32_t hfreq_hz;          // used only if pclk_hz or h_total is unknown
+} vmode_meas_t;
+
+typedef struct {
+    uint32_t hash_hits;
+    uint32_t fallback_hits;
+    uint32_t misses;
+} vmode_class_stats_t;
+
+extern vmode_class_stats_t vmode_class_stats;
+
+int vmode_classify(const vmode_meas_t *meas);
+
+const vmode_timing_t* vmode_get_timing(int mode_id);
+
+HDMI_vic_t vmode_get_vic(int mode_id, uint8_t ar_16x9);
+
+uint8_t vmode_get_pixelrep_ifr(int mode_id);
+
+#endif /* VMODE_CLASS_H_ */
@@ -26,7 +26,25 @@
 #define PCNT_TOLERANCE 50
 #define HPX16_TOLERANCE 10
 
-uint16_t afe_bw_arr[] = {9, 10, 11, 12, 14, 17, 21, 24, 30, 38, 50, 75, 83, 105, 149, 450};
+// Adaptive sync stability filter parameters
+#define SYNC_FILT_ALPHA_SHIFT       3   // EWMA weight 1/8
+#define SYNC_FILT_SIGMA_K           4   // confidence band width in standard deviations
+#define SYNC_FILT_BAND_MAX          16  // confidence band upper limit (multiple of base tolerance)
+#define SYNC_FILT_CONFIRM_SAMPLES   3   // consecutive out-of-band samples required for mode change
+
+// Sync threshold calibration
+#define ISL_SOG_VTH_MAX             31
+#define ISL_HSYNC_VTH_MAX           15
+#define VTH_CAL_SETTLE_POLLS        2   // polls to wait after threshold change before sampling
+
+// Deferred write set tags
+#define ISL_REGQ_AFEBW  0
+#define ISL_REGQ_CLAMP  1
+
+// AFE -3dB bandwidth options (MHz), also used as upper threshold for auto selection
+const uint16_t afe_bw_arr[] = {9, 10, 11, 12, 14, 17, 21, 24, 30, 38, 50, 75, 83, 105, 149, 450};
+
+#define AFE_BW_NUM  (sizeof(afe_bw_arr)/sizeof(uint16_t))
 
 const isl51002_config isl_cfg_default = {
     .col = {0x144, 0x144, 0x144, 0x200, 0x200, 0x200},
@@ -47,6 +65,9 @@ const isl51002_config isl_cfg_default = {
 };
 
 void isl_writereg(isl51002_dev *dev, uint8_t regaddr, uint8_t data) {
+    if (dev->regq)
+        regq_drop(dev->regq, dev->i2cm_base, dev->i2c_addr, regaddr, 1);
+
     I2C_start(dev->i2cm_base, dev->i2c_addr, 0);
     I2C_write(dev->i2cm_base, regaddr, 0);
     I2C_write(dev->i2cm_base, data, 1);
@@ -62,6 +83,42 @@ uint8_t isl_readreg(isl51002_dev *dev, uint8_t regaddr) {
     return I2C_read(dev->i2cm_base,1);
 }
 
+void isl_readregs(isl51002_dev *dev, uint8_t regaddr, uint8_t *buf, int len) {
+    int i;
+
+    //Phase 1
+    I2C_start(dev->i2cm_base, dev->i2c_addr, 0);
+    I2C_write(dev->i2cm_base, regaddr, 0);
+
+    //Phase 2
+    I2C_start(dev->i2cm_base, dev->i2c_addr, 1);
+    for (i=0; i<len; i++)
+        buf[i] = I2C_read(dev->i2cm_base, (i==len-1) ? 1 : 0);
+}
+
+static void isl_regq_begin(isl51002_dev *dev, uint8_t tag) {
+    if (dev->regq)
+        regq_begin(dev->regq, dev->i2cm_base, dev->i2c_addr, tag);
+}
+
+// Write register at next vertical blank if deferred write queue is attached (and not full)
+static void isl_writereg_vsync(isl51002_dev *dev, uint8_t regaddr, uint8_t data) {
+    if (!dev->regq || (regq_write(dev->regq, dev->i2cm_base, dev->i2c_addr, regaddr, data) != 0))
+        isl_writereg(dev, regaddr, data);
+}
+
+void isl_writeregs(isl51002_dev *dev, uint8_t regaddr, const uint8_t *buf, int len) {
+    int i;
+
+    if (dev->regq)
+        regq_drop(dev->regq, dev->i2cm_base, dev->i2c_addr, regaddr, len);
+
+    I2C_start(dev->i2cm_base, dev->i2c_addr, 0);
+    I2C_write(dev->i2cm_base, regaddr, 0);
+    for (i=0; i<len; i++)
+        I2C_write(dev->i2cm_base, buf[i], (i==len-1) ? 1 : 0);
+}
+
 int isl_init(isl51002_dev *dev) {
     uint8_t xtal_mhz;
 
@@ -86,6 +143,8 @@ int isl_init(isl51002_dev *dev) {
     // TODO: check optimal way
     isl_writereg(dev, ISL_MEASCFG, 0x00);
 
+    dev->htotal = isl_get_pll_htotal(dev);
+
     // fastest ABLC to minimize brightness fluctuation caused by flawed backporch clamp
     //isl_writereg(dev, ISL_ABLCCFG, 0x00);
 
@@ -98,6 +157,9 @@ int isl_init(isl51002_dev *dev) {
     isl_writereg(dev, ISL_ABLC_START_LSB, 16);
     isl_writereg(dev, ISL_CLAMPWIDTH, 16);*/
 
+    memset(&dev->vth_cal, 0, sizeof(isl51002_vth_cal));
+    dev->vth_cache_valid = 0;
+
     isl_update_config(dev, (isl51002_config*)&isl_cfg_default, 1);
 
     return 0;
@@ -129,11 +191,28 @@ void isl_source_sel(isl51002_dev *dev, isl_input_t input, video_sync syncinput,
         isl_writereg(dev, ISL_SYNCSRC, 0x00); // auto
 }
 
+static video_sync isl_decode_activity(uint8_t sync_activity) {
+    video_sync act = 0;
+
+    if ((sync_activity & 0x01) == 0x01)
+        act |= SYNC_CS;
+    if ((sync_activity & 0x03) == 0x03)
+        act |= SYNC_HV;
+    if ((sync_activity & 0x0c) != 0x00)
+        act |= SYNC_SOG;
+
+    return act;
+}
+
 int isl_check_activity(isl51002_dev *dev, isl_input_t input, video_sync syncinput) {
     uint8_t sync_active, sync_activity = 0;
-    video_sync act = 0;
+    video_sync act;
     int activity_change = 0;
 
+    // Sync drops out repeatedly during threshold sweep, keep last status until it completes
+    if (dev->vth_cal.state == ISL_VTH_CAL_RUNNING)
+        return 0;
+
     if (input == ISL_CH0)
         sync_activity = isl_readreg(dev, ISL_CH0_CH1_STATUS) & 0x0f;
     else if (input == ISL_CH1)
@@ -141,18 +220,15 @@ int isl_check_activity(isl51002_dev *dev, isl_input_t input, video_sync syncinpu
     else if (input == ISL_CH2)
         sync_activity = isl_readreg(dev, ISL_CH2_STATUS) & 0x0f;
 
-    if ((sync_activity & 0x01) == 0x01)
-        act |= SYNC_CS;
-    if ((sync_activity & 0x03) == 0x03)
-        act |= SYNC_HV;
-    if ((sync_activity & 0x0c) != 0x00)
-        act |= SYNC_SOG;
+    act = isl_decode_activity(sync_activity);
 
     sync_active = !!(act & syncinput);
 
     if (sync_active != dev->sync_active) {
         activity_change = 1;
         memset(&dev->ss, 0, sizeof(isl51002_sync_status));
+        memset(&dev->pcnt_filt, 0, sizeof(isl51002_sync_filter));
+        memset(&dev->hper_filt, 0, sizeof(isl51002_sync_filter));
 
         printf("isl activity: 0x%x\n", sync_activity);
     }
@@ -162,6 +238,91 @@ int isl_check_activity(isl51002_dev *dev, isl_input_t input, video_sync syncinpu
     return activity_change;
 }
 
+// Read sync activity of all inputs in a single transaction. Note that SOG activity
+// is only reported for channels enabled in ISL_SYNCPOLLCFG.
+uint16_t isl_scan_activity(isl51002_dev *dev) {
+    uint8_t status[2];
+
+    isl_readregs(dev, ISL_CH0_CH1_STATUS, status, 2);
+
+    return (isl_decode_activity(status[0] & 0x0f) << (3*ISL_CH0)) |
+           (isl_decode_activity(status[0] >> 4) << (3*ISL_CH1)) |
+           (isl_decode_activity(status[1] & 0x0f) << (3*ISL_CH2));
+}
+
+// Order active inputs by best available sync type (HV > CS > SOG, lower channel first on tie).
+// Returns number of active inputs written to ranked_input/ranked_sync (max 3 entries each).
+int isl_rank_inputs(uint16_t activity, isl_input_t *ranked_input, video_sync *ranked_sync) {
+    const video_sync sync_pref[] = {SYNC_HV, SYNC_CS, SYNC_SOG};
+    uint8_t ranked_mask = 0;
+    int i, ch, num_active = 0;
+
+    for (i=0; i<sizeof(sync_pref)/sizeof(video_sync); i++) {
+        for (ch=ISL_CH0; ch<=ISL_CH2; ch++) {
+            if (!(ranked_mask & (1<<ch)) && (ISL_INPUT_ACTIVITY(activity, ch) & sync_pref[i])) {
+                ranked_input[num_active] = ch;
+                ranked_sync[num_active] = sync_pref[i];
+                ranked_mask |= (1<<ch);
+                num_active++;
+            }
+        }
+    }
+
+    return num_active;
+}
+
+static void isl_sync_filter_reset(isl51002_sync_filter *filt, uint32_t val, uint32_t tolerance) {
+    // Start with sigma equal to base tolerance and let estimate settle from there
+    filt->mean_x16 = val << 4;
+    filt->var = tolerance*tolerance;
+    filt->outliers = 0;
+    filt->valid = 1;
+}
+
+// Track running mean/variance of a sync measurement and return 1 once a value has stayed
+// outside adaptive confidence band for SYNC_FILT_CONFIRM_SAMPLES consecutive samples
+static int isl_sync_filter_update(isl51002_sync_filter *filt, uint32_t val, uint32_t prev_val, uint32_t tolerance, uint32_t *reconfigs_avoided) {
+    int32_t diff_x16;
+    uint32_t diff, sq_diff;
+    int outlier;
+
+    if (!filt->valid) {
+        isl_sync_filter_reset(filt, val, tolerance);
+        return 1;
+    }
+
+    diff_x16 = (int32_t)(val << 4) - filt->mean_x16;
+    diff = ((diff_x16 < 0) ? -diff_x16 : diff_x16) >> 4;
+
+    // Band is max(tolerance, K*sigma), limited to SYNC_FILT_BAND_MAX*tolerance
+    if (diff <= tolerance) {
+        outlier = 0;
+    } else if (diff > SYNC_FILT_BAND_MAX*tolerance) {
+        outlier = 1;
+    } else {
+        sq_diff = diff*diff;
+        outlier = (sq_diff > SYNC_FILT_SIGMA_K*SYNC_FILT_SIGMA_K*filt->var);
+    }
+
+    if (outlier) {
+        if (++filt->outliers >= SYNC_FILT_CONFIRM_SAMPLES) {
+            isl_sync_filter_reset(filt, val, tolerance);
+            return 1;
+        }
+        return 0;
+    }
+
+    // Count transients and sample-to-sample jitter that would have caused a reconfiguration with fixed tolerance
+    if ((filt->outliers > 0) || (val < prev_val - tolerance) || (val > prev_val + tolerance))
+        (*reconfigs_avoided)++;
+
+    filt->outliers = 0;
+    filt->mean_x16 += diff_x16 / (1<<SYNC_FILT_ALPHA_SHIFT);
+    filt->var += ((int32_t)(diff*diff) - (int32_t)filt->var) / (1<<SYNC_FILT_ALPHA_SHIFT);
+
+    return 0;
+}
+
 int isl_get_sync_stats(isl51002_dev *dev, uint16_t vtotal, uint8_t interlace_flag, uint32_t pcnt_field) {
     uint8_t sync_params;
     uint16_t h_period_x16;
@@ -181,10 +342,7 @@ int isl_get_sync_stats(isl51002_dev *dev, uint16_t vtotal, uint8_t interlace_fla
     if (h_period_x16 == 0) {
         h_period_x16 = (16*pcnt_field)/vtotal;
     }
-    if ((h_period_x16 < (dev->sm.h_period_x16 - HPX16_TOLERANCE)) ||
-        (h_period_x16 > (dev->sm.h_period_x16 + HPX16_TOLERANCE))) {
-        isl_h_period_change = 1;
-    }
+    isl_h_period_change = isl_sync_filter_update(&dev->hper_filt, h_period_x16, dev->sm.h_period_x16, HPX16_TOLERANCE, &dev->filt_stats.reconfigs_avoided);
 
     dev->sm.h_period_x16 = h_period_x16;
     dev->sm.v_totlines = ((isl_readreg(dev, ISL_VSYNCPERIOD_MSB) & 0x0f) << 8) | isl_readreg(dev, ISL_VSYNCPERIOD_LSB);
@@ -196,15 +354,25 @@ int isl_get_sync_stats(isl51002_dev *dev, uint16_t vtotal, uint8_t interlace_fla
     dev->sm.v_active = (isl_readreg(dev, ISL_LINEWIDTH_MSB) << 8) | isl_readreg(dev, ISL_LINEWIDTH_LSB);
 #endif
 
-    if (((vtotal > 0) && (pcnt_field > 0)) &&
-        ((vtotal != dev->ss.v_total) ||
-        (interlace_flag != dev->ss.interlace_flag) ||
-        isl_h_period_change ||
-        (pcnt_field < (dev->ss.pcnt_field - PCNT_TOLERANCE)) ||
-        (pcnt_field > (dev->ss.pcnt_field + PCNT_TOLERANCE)) ||
-        ((sync_params & 0x3c) != (dev->ss.sync_params & 0x3c))))
-    {
-        mode_changed = 1;
+    if ((vtotal > 0) && (pcnt_field > 0)) {
+        // Discrete sync parameters are applied immediately, pcnt_field/h_period go through stability filter
+        if ((vtotal != dev->ss.v_total) ||
+            (interlace_flag != dev->ss.interlace_flag) ||
+            ((sync_params & 0x3c) != (dev->ss.sync_params & 0x3c)))
+        {
+            mode_changed = 1;
+            isl_sync_filter_reset(&dev->pcnt_filt, pcnt_field, PCNT_TOLERANCE);
+#ifdef ISL_SYNC_MEAS
+            isl_sync_filter_reset(&dev->hper_filt, h_period_x16, HPX16_TOLERANCE);
+#endif
+        } else {
+            mode_changed = isl_sync_filter_update(&dev->pcnt_filt, pcnt_field, dev->ss.pcnt_field, PCNT_TOLERANCE, &dev->filt_stats.reconfigs_avoided) ||
+                           isl_h_period_change;
+        }
+    }
+
+    if (mode_changed) {
+        dev->filt_stats.mode_changes++;
 
         printf("isl sync params: 0x%x\n", sync_params);
 #ifdef ISL_SYNC_MEAS
@@ -216,6 +384,7 @@ int isl_get_sync_stats(isl51002_dev *dev, uint16_t vtotal, uint8_t interlace_fla
         printf("totlines: %u\n", vtotal);
         printf("interlace_flag: %u\n", interlace_flag);
         printf("pcnt_field: %lu\n", pcnt_field);
+        printf("isl reconfigs avoided: %lu\n", dev->filt_stats.reconfigs_avoided);
     }
 
     dev->ss.sync_params = sync_params;
@@ -226,28 +395,104 @@ int isl_get_sync_stats(isl51002_dev *dev, uint16_t vtotal, uint8_t interlace_fla
     return mode_changed;
 }
 
+static void isl_calc_clamp(uint16_t h_samplerate, uint16_t clamp_alc_start_pct_x10, uint8_t clamp_alc_width_pct_x10, uint8_t sync_trilevel, uint16_t *clamp_alc_start_px, uint8_t *clamp_alc_width_px) {
+    *clamp_alc_start_px = ((uint32_t)clamp_alc_start_pct_x10*h_samplerate)/1000;
+    if (sync_trilevel)
+        *clamp_alc_start_px += 48;
+
+    *clamp_alc_width_px = ((uint32_t)clamp_alc_width_pct_x10*h_samplerate)/1000;
+}
+
+// Map pixel clock to smallest AFE bandwidth setting covering (2/3) of it
+static uint8_t isl_calc_afe_bw_sel(uint32_t dotclk_hz) {
+    uint32_t target_bw_hz = (2*dotclk_hz)/3;
+    uint8_t lo = 0, hi = AFE_BW_NUM-1, mid;
+
+    while (lo < hi) {
+        mid = (lo+hi)/2;
+        if (target_bw_hz <= afe_bw_arr[mid]*1000000UL)
+            hi = mid;
+        else
+            lo = mid+1;
+    }
+
+    return lo;
+}
+
 void isl_source_setup(isl51002_dev *dev, uint16_t h_samplerate) {
+    uint16_t clamp_alc_start_px;
+    uint8_t clamp_alc_width_px;
+    uint8_t regs[3];
+
     isl_writereg(dev, ISL_HPLL_HTOTAL_MSB, (h_samplerate >> 8));
     isl_writereg(dev, ISL_HPLL_HTOTAL_LSB, (h_samplerate & 0xff));
+    dev->htotal = h_samplerate;
+
+    // Mode change, clamp must match new htotal right away instead of waiting for vsync
+    isl_calc_clamp(h_samplerate, dev->cfg.clamp_alc_start_pct_x10, dev->cfg.clamp_alc_width_pct_x10, dev->sync_trilevel, &clamp_alc_start_px, &clamp_alc_width_px);
+    regs[0] = clamp_alc_start_px >> 8;
+    regs[1] = clamp_alc_start_px & 0xff;
+    regs[2] = clamp_alc_width_px;
+    isl_writeregs(dev, ISL_ABLC_START_MSB, regs, 3);
+
+    printf("Clamp offset: %upx\n", clamp_alc_start_px);
+    printf("Clamp width: %upx\n", clamp_alc_width_px);
+}
 
-    isl_set_clamp(dev, dev->cfg.clamp_alc_start_pct_x10, dev->cfg.clamp_alc_width_pct_x10, dev->sync_trilevel);
+// Combined isl_source_setup() and isl_set_afe_bw() for mode change. All parameters
+// are calculated upfront and written with burst transfers without readbacks.
+void isl_calc_frontend_setup(isl51002_dev *dev, uint16_t h_samplerate, uint32_t dotclk_hz, isl51002_frontend_setup *fe) {
+    fe->htotal = h_samplerate;
+    isl_calc_clamp(h_samplerate, dev->cfg.clamp_alc_start_pct_x10, dev->cfg.clamp_alc_width_pct_x10, dev->sync_trilevel, &fe->clamp_start_px, &fe->clamp_width_px);
+    fe->afe_bw_sel = isl_calc_afe_bw_sel(dotclk_hz);
+}
+
+// Program frontend setup calculated by isl_calc_frontend_setup() now or earlier (e.g. stored in a mode table)
+void isl_apply_frontend_setup(isl51002_dev *dev, const isl51002_frontend_setup *fe) {
+    uint8_t regs[3];
+
+    // Written immediately, discard any pending deferred updates to same registers
+    if (dev->regq) {
+        regq_cancel(dev->regq, dev->i2cm_base, dev->i2c_addr, ISL_REGQ_CLAMP);
+        regq_cancel(dev->regq, dev->i2cm_base, dev->i2c_addr, ISL_REGQ_AFEBW);
+    }
+
+    regs[0] = fe->htotal >> 8;
+    regs[1] = fe->htotal & 0xff;
+    isl_writeregs(dev, ISL_HPLL_HTOTAL_MSB, regs, 2);
+
+    regs[0] = fe->clamp_start_px >> 8;
+    regs[1] = fe->clamp_start_px & 0xff;
+    regs[2] = fe->clamp_width_px;
+    isl_writeregs(dev, ISL_ABLC_START_MSB, regs, 3);
+
+    dev->htotal = fe->htotal;
+    dev->auto_bw_sel = fe->afe_bw_sel;
+
+    if (!dev->cfg.afe_bw)
+        isl_writereg(dev, ISL_AFEBW, dev->auto_bw_sel);
+}
+
+void isl_frontend_setup(isl51002_dev *dev, uint16_t h_samplerate, uint32_t dotclk_hz, isl51002_frontend_setup *fe) {
+    isl_calc_frontend_setup(dev, h_samplerate, dotclk_hz, fe);
+    isl_apply_frontend_setup(dev, fe);
+
+    printf("Clamp offset: %upx\n", fe->clamp_start_px);
+    printf("Clamp width: %upx\n", fe->clamp_width_px);
+    if (!dev->cfg.afe_bw)
+        printf("AFE BW auto-set to %uMHz\n\n", afe_bw_arr[dev->auto_bw_sel]);
 }
 
 void isl_set_clamp(isl51002_dev *dev, uint16_t clamp_alc_start_pct_x10, uint8_t clamp_alc_width_pct_x10, uint8_t sync_trilevel) {
     uint16_t clamp_alc_start_px;
     uint8_t clamp_alc_width_px;
-    uint16_t h_samplerate = isl_get_pll_htotal(dev);
-
-    clamp_alc_start_px = ((uint32_t)clamp_alc_start_pct_x10*h_samplerate)/1000;
-    if (sync_trilevel)
-        clamp_alc_start_px += 48;
 
-    clamp_alc_width_px = ((uint32_t)clamp_alc_width_pct_x10*h_samplerate)/1000;
+    isl_calc_clamp(dev->htotal, clamp_alc_start_pct_x10, clamp_alc_width_pct_x10, sync_trilevel, &clamp_alc_start_px, &clamp_alc_width_px);
 
-    isl_writereg(dev, ISL_ABLC_START_MSB, (clamp_alc_start_px >> 8));
-    isl_writereg(dev, ISL_ABLC_START_LSB, (clamp_alc_start_px & 0xff));
-
-    isl_writereg(dev, ISL_CLAMPWIDTH, clamp_alc_width_px);
+    isl_regq_begin(dev, ISL_REGQ_CLAMP);
+    isl_writereg_vsync(dev, ISL_ABLC_START_MSB, (clamp_alc_start_px >> 8));
+    isl_writereg_vsync(dev, ISL_ABLC_START_LSB, (clamp_alc_start_px & 0xff));
+    isl_writereg_vsync(dev, ISL_CLAMPWIDTH, clamp_alc_width_px);
 
     printf("Clamp offset: %upx\n", clamp_alc_start_px);
     printf("Clamp width: %upx\n", clamp_alc_width_px);
@@ -287,54 +532,18 @@ uint8_t isl_get_sampler_phase(isl51002_dev *dev) {
 }
 
 uint16_t isl_get_afe_bw_value(uint8_t index) {
-    if (index >= sizeof(afe_bw_arr)/sizeof(uint16_t))
+    if (index >= AFE_BW_NUM)
         return 0;
     else
         return afe_bw_arr[index];
 }
 
 void isl_set_afe_bw(isl51002_dev *dev, uint32_t dotclk_hz) {
-    uint8_t bw_sel;
-    uint32_t target_bw_hz;
-
-    // Set AFE -3dB bandwidth to (2/3) of input pixel clock
-    target_bw_hz = (2*dotclk_hz)/3;
-
-    if (target_bw_hz <= 9000000)
-        dev->auto_bw_sel = 0x00;
-    else if (target_bw_hz <= 10000000)
-        dev->auto_bw_sel = 0x01;
-    else if (target_bw_hz <= 11000000)
-        dev->auto_bw_sel = 0x02;
-    else if (target_bw_hz <= 12000000)
-        dev->auto_bw_sel = 0x03;
-    else if (target_bw_hz <= 14000000)
-        dev->auto_bw_sel = 0x04;
-    else if (target_bw_hz <= 17000000)
-        dev->auto_bw_sel = 0x05;
-    else if (target_bw_hz <= 21000000)
-        dev->auto_bw_sel = 0x06;
-    else if (target_bw_hz <= 24000000)
-        dev->auto_bw_sel = 0x07;
-    else if (target_bw_hz <= 30000000)
-        dev->auto_bw_sel = 0x08;
-    else if (target_bw_hz <= 38000000)
-        dev->auto_bw_sel = 0x09;
-    else if (target_bw_hz <= 50000000)
-        dev->auto_bw_sel = 0x0a;
-    else if (target_bw_hz <= 75000000)
-        dev->auto_bw_sel = 0x0b;
-    else if (target_bw_hz <= 83000000)
-        dev->auto_bw_sel = 0x0c;
-    else if (target_bw_hz <= 105000000)
-        dev->auto_bw_sel = 0x0d;
-    else if (target_bw_hz <= 149000000)
-        dev->auto_bw_sel = 0x0e;
-    else
-        dev->auto_bw_sel = 0x0f;
+    dev->auto_bw_sel = isl_calc_afe_bw_sel(dotclk_hz);
 
     if (!dev->cfg.afe_bw) {
-        isl_writereg(dev, ISL_AFEBW, dev->auto_bw_sel);
+        isl_regq_begin(dev, ISL_REGQ_AFEBW);
+        isl_writereg_vsync(dev, ISL_AFEBW, dev->auto_bw_sel);
         printf("AFE BW auto-set to %uMHz\n\n", afe_bw_arr[dev->auto_bw_sel]);
     }
 }
@@ -358,6 +567,125 @@ void isl_set_de(isl51002_dev *dev) {
     isl_writereg(dev, ISL_LINEWIDTH_LSB, dev->sm.v_active & 0xff);
 }
 
+// Program threshold without touching dev->cfg, which tracks caller's configuration
+static void isl_set_vth(isl51002_dev *dev, video_sync syncinput, uint8_t vth) {
+    if (syncinput == SYNC_SOG)
+        isl_writereg(dev, ISL_SOG_VTH, vth);
+    else
+        isl_writereg(dev, ISL_HSYNC_VTH, (vth<<4) | vth);
+}
+
+static void isl_vth_cal_finish(isl51002_dev *dev) {
+    isl51002_vth_cal *cal = &dev->vth_cal;
+    uint8_t vth, cache_bit;
+
+    if (cal->best_len == 0) {
+        isl_set_vth(dev, cal->syncinput, cal->orig_vth);
+        cal->result_vth = cal->orig_vth;
+        cal->state = ISL_VTH_CAL_FAILED;
+        printf("isl %s threshold calibration failed\n", (cal->syncinput == SYNC_SOG) ? "SOG" : "Hsync");
+        return;
+    }
+
+    vth = cal->best_start + cal->best_len/2;
+    isl_set_vth(dev, cal->syncinput, vth);
+    cal->result_vth = vth;
+
+    cache_bit = (cal->syncinput == SYNC_SOG) ? (1<<cal->input) : (1<<(3+cal->input));
+    if (cal->syncinput == SYNC_SOG)
+        dev->sog_vth_cache[cal->input] = vth;
+    else
+        dev->hsync_vth_cache[cal->input] = vth;
+    dev->vth_cache_valid |= cache_bit;
+
+    cal->state = ISL_VTH_CAL_DONE;
+    printf("isl %s threshold calibrated to %u (stable %u-%u)\n", (cal->syncinput == SYNC_SOG) ? "SOG" : "Hsync", vth, cal->best_start, cal->best_start+cal->best_len-1);
+}
+
+// Start non-blocking sweep of SOG (syncinput=SYNC_SOG) or Hsync threshold for currently selected input.
+// The sweep is advanced by isl_vth_cal_poll() which should be called periodically (e.g. once per frame)
+// instead of isl_check_activity() while calibration is running. Final value is programmed to the
+// device but not stored to dev->cfg; caller must fetch it with isl_vth_cal_get_result() and copy it
+// to sog_vth/hsync_vth of its config, otherwise a forced isl_update_config() restores the old value.
+int isl_vth_cal_start(isl51002_dev *dev, isl_input_t input, video_sync syncinput, int use_cache) {
+    isl51002_vth_cal *cal = &dev->vth_cal;
+    uint8_t cache_bit = (syncinput == SYNC_SOG) ? (1<<input) : (1<<(3+input));
+
+    if (use_cache && (dev->vth_cache_valid & cache_bit)) {
+        cal->input = input;
+        cal->syncinput = syncinput;
+        cal->result_vth = (syncinput == SYNC_SOG) ? dev->sog_vth_cache[input] : dev->hsync_vth_cache[input];
+        isl_set_vth(dev, syncinput, cal->result_vth);
+        cal->state = ISL_VTH_CAL_DONE;
+        return 0;
+    }
+
+    cal->input = input;
+    cal->syncinput = syncinput;
+    cal->orig_vth = (syncinput == SYNC_SOG) ? dev->cfg.sog_vth : dev->cfg.hsync_vth;
+    cal->vth_max = (syncinput == SYNC_SOG) ? ISL_SOG_VTH_MAX : ISL_HSYNC_VTH_MAX;
+    cal->vth = 0;
+    cal->win_len = 0;
+    cal->best_len = 0;
+    cal->settle_cnt = VTH_CAL_SETTLE_POLLS;
+    cal->state = ISL_VTH_CAL_RUNNING;
+
+    isl_set_vth(dev, syncinput, cal->vth);
+
+    return 1;
+}
+
+isl_vth_cal_state isl_vth_cal_poll(isl51002_dev *dev) {
+    isl51002_vth_cal *cal = &dev->vth_cal;
+    int stable;
+
+    if (cal->state != ISL_VTH_CAL_RUNNING)
+        return cal->state;
+
+    if (cal->settle_cnt > 0) {
+        cal->settle_cnt--;
+        return cal->state;
+    }
+
+    // Step is stable if sync is detected and PLL is locked
+    stable = (ISL_INPUT_ACTIVITY(isl_scan_activity(dev), cal->input) & cal->syncinput) &&
+             (isl_readreg(dev, ISL_SYNCTYPE) & (1<<7));
+
+    if (stable) {
+        if (cal->win_len == 0)
+            cal->win_start = cal->vth;
+        cal->win_len++;
+
+        if (cal->win_len > cal->best_len) {
+            cal->best_start = cal->win_start;
+            cal->best_len = cal->win_len;
+        }
+    } else {
+        cal->win_len = 0;
+    }
+
+    if (cal->vth == cal->vth_max) {
+        isl_vth_cal_finish(dev);
+    } else {
+        cal->vth++;
+        cal->settle_cnt = VTH_CAL_SETTLE_POLLS;
+        isl_set_vth(dev, cal->syncinput, cal->vth);
+    }
+
+    return cal->state;
+}
+
+// Get threshold selected by last calibration. Returns -1 if calibration has not completed.
+// On failure the original threshold is returned along with -1.
+int isl_vth_cal_get_result(isl51002_dev *dev, uint8_t *vth) {
+    if ((dev->vth_cal.state != ISL_VTH_CAL_DONE) && (dev->vth_cal.state != ISL_VTH_CAL_FAILED))
+        return -1;
+
+    *vth = dev->vth_cal.result_vth;
+
+    return (dev->vth_cal.state == ISL_VTH_CAL_DONE) ? 0 : -1;
+}
+
 void isl_update_config(isl51002_dev *dev, isl51002_config *cfg, int force_update) {
     uint8_t val;
 
@@ -413,13 +741,15 @@ void isl_update_config(isl51002_dev *dev, isl51002_config *cfg, int force_update
         isl_writereg(dev, ISL_PLL_TUNE, 0x49+cfg->pll_loop_gain);
 
     if (force_update || (cfg->afe_bw != dev->cfg.afe_bw)) {
+        isl_regq_begin(dev, ISL_REGQ_AFEBW);
         if (!cfg->afe_bw) {
-            isl_writereg(dev, ISL_AFEBW, dev->auto_bw_sel);
+            isl_writereg_vsync(dev, ISL_AFEBW, dev->auto_bw_sel);
             printf("AFE BW auto-set to %uMHz\n\n", afe_bw_arr[dev->auto_bw_sel]);
         } else {
-            isl_writereg(dev, ISL_AFEBW, cfg->afe_bw-1);
+            isl_writereg_vsync(dev, ISL_AFEBW, cfg->afe_bw-1);
             printf("AFE BW manually set to %uMHz\n\n", afe_bw_arr[cfg->afe_bw-1]);
         }
     }
 
-    memcpy(&dev->cfg, cfg, sizeof(isl51002_config));}
+    memcpy(&dev->cfg, cfg, sizeof(isl51002_config));
+}
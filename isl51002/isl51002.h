@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include "sysconfig.h"
+#include "regq.h"
 #include "isl51002_regs.h"
 
 //#define ISL_SYNC_MEAS
@@ -83,6 +84,47 @@ typedef struct {
     uint16_t v_active;
 } isl51002_sync_meas;
 
+typedef struct {
+    int32_t mean_x16;
+    uint32_t var;
+    uint8_t outliers;
+    uint8_t valid;
+} isl51002_sync_filter;
+
+typedef struct {
+    uint32_t mode_changes;
+    uint32_t reconfigs_avoided;
+} isl51002_sync_filter_stats;
+
+typedef struct {
+    uint16_t htotal;
+    uint16_t clamp_start_px;
+    uint8_t clamp_width_px;
+    uint8_t afe_bw_sel;
+} isl51002_frontend_setup;
+
+typedef enum {
+    ISL_VTH_CAL_IDLE = 0,
+    ISL_VTH_CAL_RUNNING,
+    ISL_VTH_CAL_DONE,
+    ISL_VTH_CAL_FAILED
+} isl_vth_cal_state;
+
+typedef struct {
+    isl_vth_cal_state state;
+    uint8_t input;
+    uint8_t syncinput;
+    uint8_t orig_vth;
+    uint8_t vth;
+    uint8_t vth_max;
+    uint8_t settle_cnt;
+    uint8_t win_start;
+    uint8_t win_len;
+    uint8_t best_start;
+    uint8_t best_len;
+    uint8_t result_vth;
+} isl51002_vth_cal;
+
 typedef struct {
     uint32_t i2cm_base;
     uint8_t i2c_addr;
@@ -92,9 +134,18 @@ typedef struct {
     uint8_t sync_active;
     uint8_t sync_trilevel;
     uint8_t auto_bw_sel;
+    uint16_t htotal;
     isl51002_config cfg;
     isl51002_sync_status ss;
     isl51002_sync_meas sm;
+    isl51002_sync_filter pcnt_filt;
+    isl51002_sync_filter hper_filt;
+    isl51002_sync_filter_stats filt_stats;
+    regq_t *regq;
+    isl51002_vth_cal vth_cal;
+    uint8_t sog_vth_cache[3];
+    uint8_t hsync_vth_cache[3];
+    uint8_t vth_cache_valid;
 } isl51002_dev;
 
 typedef enum {
@@ -116,11 +167,18 @@ typedef enum {
     SYNC_CS = (1<<2)
 } video_sync;
 
+// Per-input activity bitmap returned by isl_scan_activity (3 bits per input)
+#define ISL_INPUT_ACTIVITY(act, input)  (((act) >> (3*(input))) & 0x7)
+
 
 void isl_writereg(isl51002_dev *dev, uint8_t regaddr, uint8_t data);
 
 uint8_t isl_readreg(isl51002_dev *dev, uint8_t regaddr);
 
+void isl_readregs(isl51002_dev *dev, uint8_t regaddr, uint8_t *buf, int len);
+
+void isl_writeregs(isl51002_dev *dev, uint8_t regaddr, const uint8_t *buf, int len);
+
 int isl_init(isl51002_dev *dev);
 
 void isl_get_default_cfg(isl51002_config *cfg);
@@ -133,11 +191,21 @@ void isl_source_sel(isl51002_dev *dev, isl_input_t input, video_sync syncinput,
 
 int isl_check_activity(isl51002_dev *dev, isl_input_t input, video_sync syncinput);
 
+uint16_t isl_scan_activity(isl51002_dev *dev);
+
+int isl_rank_inputs(uint16_t activity, isl_input_t *ranked_input, video_sync *ranked_sync);
+
 // vtotal/interlace_flag/pcnt_field must be provided externally as isl51002 measurements are not reliable/accurate enough
 int isl_get_sync_stats(isl51002_dev *dev, uint16_t vtotal, uint8_t interlace_flag, uint32_t pcnt_field);
 
 void isl_source_setup(isl51002_dev *dev, uint16_t h_samplerate);
 
+void isl_calc_frontend_setup(isl51002_dev *dev, uint16_t h_samplerate, uint32_t dotclk_hz, isl51002_frontend_setup *fe);
+
+void isl_apply_frontend_setup(isl51002_dev *dev, const isl51002_frontend_setup *fe);
+
+void isl_frontend_setup(isl51002_dev *dev, uint16_t h_samplerate, uint32_t dotclk_hz, isl51002_frontend_setup *fe);
+
 void isl_set_clamp(isl51002_dev *dev, uint16_t clamp_alc_start_pct_x10, uint8_t clamp_alc_width_pct_x10, uint8_t sync_trilevel) ;
 
 uint16_t isl_get_pll_htotal(isl51002_dev *dev);
@@ -154,6 +222,12 @@ uint16_t isl_get_afe_bw(isl51002_dev *dev, uint8_t afe_bw);
 
 void isl_set_de(isl51002_dev *dev);
 
+int isl_vth_cal_start(isl51002_dev *dev, isl_input_t input, video_sync syncinput, int use_cache);
+
+isl_vth_cal_state isl_vth_cal_poll(isl51002_dev *dev);
+
+int isl_vth_cal_get_result(isl51002_dev *dev, uint8_t *vth);
+
 void isl_update_config(isl51002_dev *dev, isl51002_config *cfg, int force_update);
 
 #endif /* ISL51002_H_ */
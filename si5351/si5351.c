@@ -20,10 +20,14 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <unistd.h>
 #include "si5351.h"
 #include "utils.h"
 #include "i2c_opencores.h"
 
+// Fixed point precision for evaluating divider approximation errors
+#define SI_FRAC_Q_BITS      40
+
 si5351c_revb_register_t const si5351c_revb_registers[] =
 {
     //Sys init mask
@@ -127,6 +131,7 @@ static uint8_t si5351_readreg(si5351_dev *dev, uint8_t regaddr)
 
     //Phase 2
     I2C_start(dev->i2cm_base, dev->i2c_addr, 1);
+    dev->stats.read_xfers++;
     return I2C_read(dev->i2cm_base,1);
 }
 
@@ -135,12 +140,64 @@ static void si5351_writereg(si5351_dev *dev, uint8_t regaddr, uint8_t data)
     I2C_start(dev->i2cm_base, dev->i2c_addr, 0);
     I2C_write(dev->i2cm_base, regaddr, 0);
     I2C_write(dev->i2cm_base, data, 1);
+
+    dev->stats.write_xfers++;
+    dev->stats.bytes_written++;
+}
+
+static void si5351_readregs(si5351_dev *dev, uint8_t regaddr, uint8_t *buf, int len)
+{
+    int i;
+
+    //Phase 1
+    I2C_start(dev->i2cm_base, dev->i2c_addr, 0);
+    I2C_write(dev->i2cm_base, regaddr, 0);
+
+    //Phase 2
+    I2C_start(dev->i2cm_base, dev->i2c_addr, 1);
+    for (i=0; i<len; i++)
+        buf[i] = I2C_read(dev->i2cm_base, (i == len-1));
+
+    dev->stats.read_xfers++;
+}
+
+static void si5351_writeregs(si5351_dev *dev, uint8_t regaddr, const uint8_t *buf, int len)
+{
+    int i;
+
+    I2C_start(dev->i2cm_base, dev->i2c_addr, 0);
+    I2C_write(dev->i2cm_base, regaddr, 0);
+
+    for (i=0; i<len; i++)
+        I2C_write(dev->i2cm_base, buf[i], (i == len-1));
+
+    dev->stats.write_xfers++;
+    dev->stats.bytes_written += len;
+}
+
+// Integer mode (FB_INT/MS_INT) is only valid for even integer divider ratios
+static int si5351_ms_is_int(uint32_t p1, uint32_t p2) {
+    return ((p1 % 256) == 0) && (p2 == 0);
+}
+
+static void si5351_get_msn_regs(const si5351_pll_msn_config_t *cfg, uint8_t *regs) {
+    regs[0] = (cfg->p3 >> 8) & 0xff;
+    regs[1] = (cfg->p3 & 0xff);
+    regs[2] = (cfg->p1 >> 16) & 0x3;
+    regs[3] = (cfg->p1 >> 8) & 0xff;
+    regs[4] = (cfg->p1 & 0xff);
+    regs[5] = (((cfg->p3 >> 16) & 0xf) << 4) | ((cfg->p2 >> 16) & 0xf);
+    regs[6] = (cfg->p2 >> 8) & 0xff;
+    regs[7] = (cfg->p2 & 0xff);
 }
 
 static int si5351_set_pll_fb_multisynth(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_pll_msn_config_t *cfg) {
     uint8_t fb_int_reg;
     uint8_t msn_base = SI5351_MSNA_BASE + pll_ch*8;
 
+    // New nominal config which fine trim is relative to
+    memcpy(&dev->pll_msn_nominal[pll_ch], cfg, sizeof(si5351_pll_msn_config_t));
+
     if (!memcmp(&dev->pll_msn_config[pll_ch], cfg, sizeof(si5351_pll_msn_config_t)))
         return 0;
 
@@ -155,7 +212,7 @@ static int si5351_set_pll_fb_multisynth(si5351_dev *dev, si5351_pll_ch pll_ch, s
 
     fb_int_reg = si5351_readreg(dev, SI5351_CLK6_CTRL+pll_ch);
     fb_int_reg &= ~(1<<6);
-    if ((cfg->p1 % 256) == 0) {
+    if (si5351_ms_is_int(cfg->p1, cfg->p2)) {
         fb_int_reg |= (1<<6);
         printf("Si5351 set PLL FB multisynth to integer mode\n");
     }
@@ -187,7 +244,7 @@ static int si5351_set_output_multisynth(si5351_dev *dev, si5351_out_ch out_ch, s
 
         ms_int_reg = si5351_readreg(dev, SI5351_CLK0_CTRL+out_ch);
         ms_int_reg &= ~(1<<6);
-        if ((cfg->p1 % 256) == 0) {
+        if (si5351_ms_is_int(cfg->p1, cfg->p2)) {
             ms_int_reg |= (1<<6);
             printf("Si5351 set Output multisynth to integer mode\n");
         }
@@ -203,10 +260,10 @@ static int si5351_set_output_multisynth(si5351_dev *dev, si5351_out_ch out_ch, s
     return 1;
 }
 
-static void si5351_configure_pll(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_clk_src clksrc, uint8_t clkin_div_regval) {
-    uint8_t acc_reg;
+static int si5351_configure_pll(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_clk_src clksrc, uint8_t clkin_div_regval) {
+    uint8_t acc_reg, prev_reg;
 
-    acc_reg = si5351_readreg(dev, SI5351_PLL_SRC);
+    acc_reg = prev_reg = si5351_readreg(dev, SI5351_PLL_SRC);
     acc_reg &= ~(1<<(2+pll_ch));
     acc_reg |= (clksrc<<(2+pll_ch));
 
@@ -215,7 +272,12 @@ static void si5351_configure_pll(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_c
         acc_reg |= (clkin_div_regval<<6);
     }
 
+    if (acc_reg == prev_reg)
+        return 0;
+
     si5351_writereg(dev, SI5351_PLL_SRC, acc_reg);
+
+    return 1;
 }
 
 static void si5351_configure_clk(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch out_ch, si5351_clk_src clksrc, uint8_t bypass) {
@@ -236,8 +298,23 @@ static void si5351_enable_output(si5351_dev *dev, si5351_out_ch out_ch) {
     si5351_writereg(dev, SI5351_OEN_CTRL, acc_reg);
 }
 
+// Configuration written before init has completed would be lost to SYS_INIT / register load and its PLL lock could
+// not be tracked, so such requests are rejected before the device is touched.
+static int si5351_check_ready(si5351_dev *dev) {
+    if ((dev->state == SI_STATE_RESET) || (dev->state == SI_STATE_SYSINIT) || (dev->state == SI_STATE_INIT_FAILED)) {
+        printf("ERROR: Si5351 not initialized\n\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+// Only called after si5351_check_ready(), so lock tracking always starts
 static inline void si5351_pll_reset(si5351_dev *dev, si5351_pll_ch pll_ch) {
     si5351_writereg(dev, SI5351_PLL_RESET, (1<<(5+2*pll_ch)));
+
+    // Track relock so that caller can wait exactly until lock via si5351_poll()
+    si5351_lock_start(dev, (pll_ch == SI_PLLA) ? SI_STATUS_LOL_A : SI_STATUS_LOL_B);
 }
 
 static void si5351_set_output_divider(si5351_dev *dev, si5351_out_ch out_ch, uint8_t outdiv) {
@@ -260,109 +337,475 @@ static void si5351_set_output_divider(si5351_dev *dev, si5351_out_ch out_ch, uin
     }
 }
 
-int si5351_set_frac_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch out_ch, si5351_clk_src clksrc, uint32_t clkin_hz, uint32_t mult_numer, uint32_t mult_denom, si5351_ms_config_t *ms_conf) {
-    si5351_ms_config_t ms_conf_gen = {0};
-    si5351_pll_msn_config_t pll_msn_config;
-    si5351_out_ms_config_t out_ms_config;
-    uint32_t outdiv_x100, msn_a, msn_b, msn_c, ms_a;
-    uint32_t clksrc_hz, clkout_hz;
-    uint32_t frac_gcd;
-    uint8_t clkin_div;
-    int pll_rst_needed;
+// floor(n/d * 2^SI_FRAC_Q_BITS) for n < d without 128-bit intermediates
+static uint64_t si5351_frac_q(uint64_t n, uint64_t d) {
+    uint64_t q = 0;
+    int i;
 
-    // Generate multisynth config if one is not given
-    if (!ms_conf) {
-        clksrc_hz = (clksrc == SI_CLKIN) ? clkin_hz : dev->xtal_freq;
-        clkin_div = (clksrc_hz / SI_CLKIN_MAX_FREQ) + 1;
-        if (clkin_div > 4) {
-            clkin_div = 8;
-            ms_conf_gen.clkin_div_regval = 3;
-        } else if (clkin_div > 2) {
-            clkin_div = 4;
-            ms_conf_gen.clkin_div_regval = 2;
+    for (i=0; i<SI_FRAC_Q_BITS; i++) {
+        q <<= 1;
+        if (n >= d - n) {
+            n -= d - n;
+            q |= 1;
         } else {
-            ms_conf_gen.clkin_div_regval = clkin_div-1;
+            n <<= 1;
         }
+    }
 
-        if (!mult_numer || !mult_denom) {
-            printf("ERROR: Si5351 invalid frac numerator/denominator\n\n");
-            return -1;
-        }
+    return q;
+}
 
-        // Initial reduction
-        frac_gcd = gcd(mult_numer, mult_denom);
-        mult_numer /= frac_gcd;
-        mult_denom /= frac_gcd;
+// Relative error of a+b/c against a_ref+rem/den in ppb, saturated to int32 range
+static int32_t si5351_frac_err_ppb(uint32_t a, uint32_t b, uint32_t c, uint32_t a_ref, uint64_t rem, uint64_t den) {
+    uint64_t x, x_ref, diff, ppb;
 
-        clkout_hz = (((clksrc_hz*10)/mult_denom)*mult_numer)/10;
-        printf("Si5351 calculated output freq: %luHz\n\n", clkout_hz);
+    x = ((uint64_t)a << SI_FRAC_Q_BITS) + si5351_frac_q(b, c);
+    x_ref = ((uint64_t)a_ref << SI_FRAC_Q_BITS) + si5351_frac_q(rem, den);
+    if (x_ref == 0)
+        return INT32_MAX;
 
-        if ((clksrc_hz < SI_CLKIN_MIN_FREQ) || (clkout_hz > SI_MAX_OUTPUT_FREQ)) {
-            printf("ERROR: Si5351 input/output freq range exceeded\n\n");
-            return -1;
+    diff = (x > x_ref) ? (x - x_ref) : (x_ref - x);
+    while (diff >= (1ULL<<34)) {
+        diff >>= 1;
+        x_ref >>= 1;
+    }
+
+    ppb = (diff*1000000000ULL + x_ref/2) / x_ref;
+    if (ppb > INT32_MAX)
+        ppb = INT32_MAX;
+
+    return (x >= x_ref) ? (int32_t)ppb : -(int32_t)ppb;
+}
+
+// Find fraction b/c closest to p/q with c <= max_c using continued fraction convergents and semiconvergents
+static void si5351_best_frac(uint32_t p, uint32_t q, uint32_t max_c, uint32_t *b, uint32_t *c) {
+    uint64_t h_prev = 0, h = 1, k_prev = 1, k = 0, h_new, k_new, t, e, e_new;
+    uint32_t num = p, den = q, a, r;
+
+    while (den) {
+        a = num/den;
+
+        if (k_prev + a*k > max_c) {
+            // Largest semiconvergent within limit, use it if closer than last convergent
+            t = (max_c - k_prev) / k;
+            h_new = h_prev + t*h;
+            k_new = k_prev + t*k;
+            // |p/q - h/k| = |p*k - h*q|/(q*k), where numerators stay below q for (semi)convergents
+            e = (p*k > h*q) ? (p*k - h*q) : (h*q - p*k);
+            e_new = (p*k_new > h_new*q) ? (p*k_new - h_new*q) : (h_new*q - p*k_new);
+            if ((t > 0) && (e_new*k < e*k_new)) {
+                h = h_new;
+                k = k_new;
+            }
+            break;
         }
 
-        // use even outdiv for lowest jitter
-        outdiv_x100 = (SI_VCO_CENTER_FREQ / (clkout_hz / 100));
-        ms_a = 2*((outdiv_x100+100)/200);
-        if (ms_a >= 2048) {
-            printf("ERROR: Si5351 out of range ms_a: %lu\n\n", ms_a);
-            return -1;
+        h_new = h_prev + a*h;
+        k_new = k_prev + a*k;
+        h_prev = h;
+        h = h_new;
+        k_prev = k;
+        k = k_new;
+
+        r = num % den;
+        num = den;
+        den = r;
+    }
+
+    *b = h;
+    *c = k;
+}
+
+static uint64_t si5351_gcd64(uint64_t a, uint64_t b) {
+    uint64_t t;
+
+    while (b) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+// Total error of output driven by a VCO with error fb_err_ppb through a divider with error ms_err_ppb
+static int32_t si5351_chain_err_ppb(int32_t fb_err_ppb, int32_t ms_err_ppb) {
+    int64_t err;
+
+    if (ms_err_ppb <= -1000000000L)
+        return INT32_MAX;
+
+    err = (((int64_t)fb_err_ppb - ms_err_ppb) * 1000000000LL) / (1000000000LL + ms_err_ppb);
+    if (err > INT32_MAX)
+        err = INT32_MAX;
+    else if (err < -INT32_MAX)
+        err = -INT32_MAX;
+
+    return (int32_t)err;
+}
+
+// Get a+b/c for num/den with c limited to 20 bits. Returns relative error of approximation in ppb.
+static int32_t si5351_plan_frac(uint64_t num, uint64_t den, uint32_t *a, uint32_t *b, uint32_t *c) {
+    uint64_t rem, rem_s, den_s;
+    uint32_t a_ref;
+
+    a_ref = *a = num / den;
+    rem = num % den;
+
+    if (rem == 0) {
+        *b = 0;
+        *c = 1;
+        return 0;
+    }
+
+    // Exact fraction fits into 20 bits
+    if (den <= 1048575) {
+        *b = rem;
+        *c = den;
+        return 0;
+    }
+
+    // Not a valid divider, rejected by caller
+    if ((a_ref == 0) || (a_ref > 2048)) {
+        *b = 0;
+        *c = 1;
+        return INT32_MAX;
+    }
+
+    // Continued fraction search works on 32-bit terms, drop LSBs of larger fractions. Error
+    // is still evaluated against the original fraction.
+    rem_s = rem;
+    den_s = den;
+    while (den_s > 0xffffffffULL) {
+        den_s >>= 1;
+        rem_s >>= 1;
+    }
+
+    si5351_best_frac(rem_s, den_s, 1048575, b, c);
+    if (*b == *c) {
+        (*a)++;
+        *b = 0;
+        *c = 1;
+    }
+
+    return si5351_frac_err_ppb(*a, *b, *c, a_ref, rem, den);
+}
+
+// Find multisynth config for clkout = clksrc_hz*mult_numer/mult_denom by evaluating all valid
+// (clkin_div, ms_a, msn_a/b/c) combinations. Candidates are ranked by VCO range validity, frequency
+// error, integer feedback mode and VCO distance from center frequency. Feedback fractions whose
+// denominator exceeds 20 bits are replaced by the closest representable fraction, and resulting
+// frequency error is reported via err_ppb. Returns 0 for exact solution, 1 for approximated solution,
+// -1 on invalid parameters and -2 if no solution exists.
+int si5351_calc_frac_mult(si5351_clk_src clksrc, uint32_t clksrc_hz, uint32_t mult_numer, uint32_t mult_denom, si5351_ms_config_t *ms_conf, int32_t *err_ppb) {
+    const uint8_t clkin_div_arr[] = {1, 2, 4, 8};
+    uint64_t n;
+    uint32_t frac_gcd, clkout_hz, vco_hz, vco_dist, k, d, msn_a, msn_b, msn_c, ms_a, ms_a_min, ms_a_max;
+    uint32_t abs_err, best_abs_err = 0xffffffff, best_vco_dist = 0xffffffff;
+    int32_t err;
+    uint8_t vco_err, fb_frac, best_vco_err = 0xff, best_fb_frac = 0xff;
+    int i, found = 0, approx = 0;
+
+    if (!mult_numer || !mult_denom)
+        return -1;
+
+    // Initial reduction
+    frac_gcd = gcd(mult_numer, mult_denom);
+    mult_numer /= frac_gcd;
+    mult_denom /= frac_gcd;
+
+    clkout_hz = ((uint64_t)clksrc_hz*mult_numer)/mult_denom;
+
+    if ((clksrc_hz < SI_CLKIN_MIN_FREQ) || (clkout_hz == 0) || (clkout_hz > SI_MAX_OUTPUT_FREQ))
+        return -1;
+
+    // Output multisynth must be in DIVBY4 mode above 150MHz, otherwise use even dividers for lowest jitter
+    if (clkout_hz >= 150000000UL) {
+        ms_a_min = ms_a_max = 4;
+    } else {
+        ms_a_min = ((SI_VCO_MIN_FREQ / clkout_hz) + 1) & ~1;
+        ms_a_max = (SI_VCO_MAX_FREQ / clkout_hz) & ~1;
+        if (ms_a_min < 6)
+            ms_a_min = 6;
+        if (ms_a_max > 2046)
+            ms_a_max = 2046;
+        // Allow out-of-range VCO as a fallback for frequencies without in-range even divider
+        if (ms_a_min > ms_a_max) {
+            ms_a_max = ms_a_min;
+            if (ms_a_max > 2046)
+                return -1;
         }
+    }
 
-        if ((clkout_hz >= 150000000UL) || (ms_a <= 4)) {
-            ms_conf_gen.divby4 = 3;
-            ms_a = 4;
-        } else {
-            ms_conf_gen.ms_p1 = 128*ms_a - 512;
+    for (i=0; i<sizeof(clkin_div_arr)/sizeof(uint8_t); i++) {
+        // Input divider only exists on CLKIN path and PFD must stay within its range
+        if ((clkin_div_arr[i] > 1) && (clksrc != SI_CLKIN))
+            break;
+        if (clksrc_hz/clkin_div_arr[i] > SI_CLKIN_MAX_FREQ)
+            continue;
+        if (clksrc_hz/clkin_div_arr[i] < SI_CLKIN_MIN_FREQ)
+            break;
+
+        for (ms_a=ms_a_min; ms_a<=ms_a_max; ms_a+=2) {
+            // Feedback ratio = clkin_div*ms_a*mult_numer/mult_denom, reduced
+            k = clkin_div_arr[i]*ms_a;
+            frac_gcd = gcd(k, mult_denom);
+            k /= frac_gcd;
+            d = mult_denom / frac_gcd;
+
+            n = (uint64_t)mult_numer*k;
+            if ((n < 15*(uint64_t)d) || (n > 90*(uint64_t)d))
+                continue;
+
+            msn_a = n / d;
+            msn_b = n % d;
+            msn_c = d;
+            err = 0;
+
+            if (msn_c > 1048575) {
+                si5351_best_frac(msn_b, d, 1048575, &msn_b, &msn_c);
+                if (msn_b == msn_c) {
+                    msn_a++;
+                    msn_b = 0;
+                    msn_c = 1;
+                }
+                err = si5351_frac_err_ppb(msn_a, msn_b, msn_c, n/d, n%d, d);
+            }
+
+            if ((msn_a == 90) && msn_b)
+                continue;
+
+            vco_hz = (clksrc_hz/clkin_div_arr[i])*msn_a + (uint32_t)(((uint64_t)(clksrc_hz/clkin_div_arr[i])*msn_b)/msn_c);
+            vco_err = (vco_hz < SI_VCO_MIN_FREQ) || (vco_hz > SI_VCO_MAX_FREQ);
+            abs_err = (err < 0) ? -err : err;
+            fb_frac = (msn_b != 0) || (msn_a % 2);
+            vco_dist = (vco_hz > SI_VCO_CENTER_FREQ) ? (vco_hz - SI_VCO_CENTER_FREQ) : (SI_VCO_CENTER_FREQ - vco_hz);
+
+            if ((vco_err < best_vco_err) ||
+                ((vco_err == best_vco_err) && (abs_err < best_abs_err)) ||
+                ((vco_err == best_vco_err) && (abs_err == best_abs_err) && (fb_frac < best_fb_frac)) ||
+                ((vco_err == best_vco_err) && (abs_err == best_abs_err) && (fb_frac == best_fb_frac) && (vco_dist < best_vco_dist)))
+            {
+                best_vco_err = vco_err;
+                best_abs_err = abs_err;
+                best_fb_frac = fb_frac;
+                best_vco_dist = vco_dist;
+                approx = (d > 1048575);
+
+                memset(ms_conf, 0, sizeof(si5351_ms_config_t));
+                ms_conf->msn_p1 = 128*msn_a + ((128*msn_b)/msn_c) - 512;
+                ms_conf->msn_p2 = 128*msn_b - msn_c*((128*msn_b)/msn_c);
+                ms_conf->msn_p3 = msn_c;
+                if (ms_a == 4)
+                    ms_conf->divby4 = 3;
+                else
+                    ms_conf->ms_p1 = 128*ms_a - 512;
+                ms_conf->ms_p3 = 1;
+                ms_conf->clkin_div_regval = i;
+                if (err_ppb)
+                    *err_ppb = err;
+                found = 1;
+            }
         }
-        ms_conf_gen.ms_p3 = 1;
+    }
 
-        mult_numer = clkin_div*ms_a*mult_numer;
-        frac_gcd = gcd(mult_numer, mult_denom);
-        mult_numer /= frac_gcd;
-        mult_denom /= frac_gcd;
+    if (!found)
+        return -2;
 
-        msn_a = mult_numer / mult_denom;
-        msn_b = mult_numer % mult_denom;
-        msn_c = mult_denom;
+    return approx;
+}
 
-        if (msn_c > 1048575) {
-            printf("ERROR: Si5351 out of range msn_c: %lu\n\n", msn_c);
-            return -1;
+// Precalculated multisynth configs for standard pixel clocks from 27MHz XTAL, and for line multiplier
+// ratios from CLKIN at the standard 13.5MHz (240p/480i), 27MHz (480p) and 74.25MHz (720p/1080i) rates
+static const si5351_ms_table_entry_t si5351_ms_table[] = {
+    // 25.175MHz (VIC 1 @ 59.94Hz)
+    {SI_XTAL, 27000000UL, 1007UL, 1080UL, {3068, 16, 36, 3328, 0, 1, 0, 0, 0}},
+    // 25.2MHz (VIC 1)
+    {SI_XTAL, 27000000UL, 14UL, 15UL, {3072, 0, 1, 3328, 0, 1, 0, 0, 0}},
+    // 27MHz (VIC 2/3/6/7 @ 59.94Hz, VIC 17/18/21/22)
+    {SI_XTAL, 27000000UL, 1UL, 1UL, {3072, 0, 1, 3072, 0, 1, 0, 0, 0}},
+    // 27.027MHz (VIC 2/3/6/7)
+    {SI_XTAL, 27000000UL, 1001UL, 1000UL, {3075, 146, 250, 3072, 0, 1, 0, 0, 0}},
+    // 54MHz (VIC 14/15 @ 59.94Hz, VIC 29/30)
+    {SI_XTAL, 27000000UL, 2UL, 1UL, {3072, 0, 1, 1280, 0, 1, 0, 0, 0}},
+    // 54.054MHz (VIC 14/15)
+    {SI_XTAL, 27000000UL, 1001UL, 500UL, {3075, 146, 250, 1280, 0, 1, 0, 0, 0}},
+    // 74.176MHz (VIC 4/5 @ 59.94Hz)
+    {SI_XTAL, 27000000UL, 250UL, 91UL, {3004, 44, 91, 768, 0, 1, 0, 0, 0}},
+    // 74.25MHz (VIC 4/5/19/20)
+    {SI_XTAL, 27000000UL, 11UL, 4UL, {3008, 0, 2, 768, 0, 1, 0, 0, 0}},
+    // 108MHz (VIC 35/36 @ 59.94Hz, VIC 37/38)
+    {SI_XTAL, 27000000UL, 4UL, 1UL, {2560, 0, 1, 256, 0, 1, 0, 0, 0}},
+    // 108.108MHz (VIC 35/36)
+    {SI_XTAL, 27000000UL, 1001UL, 250UL, {2563, 9, 125, 256, 0, 1, 0, 0, 0}},
+    // 148.352MHz (VIC 16 @ 59.94Hz)
+    {SI_XTAL, 27000000UL, 500UL, 91UL, {3707, 71, 91, 256, 0, 1, 0, 0, 0}},
+    // 148.5MHz (VIC 16/31)
+    {SI_XTAL, 27000000UL, 11UL, 2UL, {3712, 0, 1, 256, 0, 1, 0, 0, 0}},
+    // 296.703MHz (VIC 63 @ 119.88Hz)
+    {SI_XTAL, 27000000UL, 1000UL, 91UL, {5114, 34, 91, 0, 0, 1, 0, 0, 3}},
+    // 297MHz (VIC 63/64)
+    {SI_XTAL, 27000000UL, 11UL, 1UL, {5120, 0, 1, 0, 0, 1, 0, 0, 3}},
+    // 13.5MHz line2x
+    {SI_CLKIN, 13500000UL, 2UL, 1UL, {6656, 0, 1, 3072, 0, 1, 0, 0, 0}},
+    // 13.5MHz line3x
+    {SI_CLKIN, 13500000UL, 3UL, 1UL, {6400, 0, 1, 1792, 0, 1, 0, 0, 0}},
+    // 13.5MHz line4x
+    {SI_CLKIN, 13500000UL, 4UL, 1UL, {6656, 0, 1, 1280, 0, 1, 0, 0, 0}},
+    // 13.5MHz line5x
+    {SI_CLKIN, 13500000UL, 5UL, 1UL, {7168, 0, 1, 1024, 0, 1, 0, 0, 0}},
+    // 27MHz line2x
+    {SI_CLKIN, 27000000UL, 2UL, 1UL, {3072, 0, 1, 1280, 0, 1, 0, 0, 0}},
+    // 27MHz line3x
+    {SI_CLKIN, 27000000UL, 3UL, 1UL, {3328, 0, 1, 768, 0, 1, 0, 0, 0}},
+    // 27MHz line4x
+    {SI_CLKIN, 27000000UL, 4UL, 1UL, {2560, 0, 1, 256, 0, 1, 0, 0, 0}},
+    // 27MHz line5x
+    {SI_CLKIN, 27000000UL, 5UL, 1UL, {3328, 0, 1, 256, 0, 1, 0, 0, 0}},
+    // 74.25MHz line2x (CLKIN divided by 2)
+    {SI_CLKIN, 74250000UL, 2UL, 1UL, {2560, 0, 1, 256, 0, 1, 1, 0, 0}},
+};
+
+// Look up multisynth config from precalculated table and LRU cache. Ratio must be reduced.
+static const si5351_ms_config_t* si5351_lookup_ms_config(si5351_dev *dev, si5351_clk_src clksrc, uint32_t clksrc_hz, uint32_t mult_numer, uint32_t mult_denom) {
+    si5351_ms_cache_entry_t *entry;
+    int i;
+
+    for (i=0; i<sizeof(si5351_ms_table)/sizeof(si5351_ms_table_entry_t); i++) {
+        if ((si5351_ms_table[i].clksrc == clksrc) &&
+            (si5351_ms_table[i].clksrc_hz == clksrc_hz) &&
+            (si5351_ms_table[i].mult_numer == mult_numer) &&
+            (si5351_ms_table[i].mult_denom == mult_denom))
+        {
+            dev->frac_err_ppb = 0;
+            return &si5351_ms_table[i].ms_conf;
         }
+    }
 
-        ms_conf_gen.msn_p1 = 128*msn_a + ((128*msn_b)/msn_c) - 512;
-        ms_conf_gen.msn_p2 = 128*msn_b - msn_c*((128*msn_b)/msn_c);
-        ms_conf_gen.msn_p3 = msn_c;
+    for (i=0; i<SI_MS_CACHE_SIZE; i++) {
+        entry = &dev->ms_cache[i];
+        if ((entry->key_conf.mult_denom != 0) &&
+            (entry->key_conf.clksrc == clksrc) &&
+            (entry->key_conf.clksrc_hz == clksrc_hz) &&
+            (entry->key_conf.mult_numer == mult_numer) &&
+            (entry->key_conf.mult_denom == mult_denom))
+        {
+            entry->last_used = ++dev->ms_cache_tick;
+            dev->frac_err_ppb = entry->err_ppb;
+            return &entry->key_conf.ms_conf;
+        }
+    }
+
+    return NULL;
+}
+
+// Store generated multisynth config in place of least recently used (or empty) cache entry
+static const si5351_ms_config_t* si5351_cache_ms_config(si5351_dev *dev, si5351_clk_src clksrc, uint32_t clksrc_hz, uint32_t mult_numer, uint32_t mult_denom, const si5351_ms_config_t *ms_conf) {
+    si5351_ms_cache_entry_t *entry = &dev->ms_cache[0];
+    int i;
+
+    for (i=1; i<SI_MS_CACHE_SIZE; i++) {
+        if (entry->key_conf.mult_denom == 0)
+            break;
+        if ((dev->ms_cache[i].key_conf.mult_denom == 0) || (dev->ms_cache[i].last_used < entry->last_used))
+            entry = &dev->ms_cache[i];
+    }
+
+    entry->key_conf.clksrc = clksrc;
+    entry->key_conf.clksrc_hz = clksrc_hz;
+    entry->key_conf.mult_numer = mult_numer;
+    entry->key_conf.mult_denom = mult_denom;
+    memcpy(&entry->key_conf.ms_conf, ms_conf, sizeof(si5351_ms_config_t));
+    entry->err_ppb = dev->frac_err_ppb;
+    entry->last_used = ++dev->ms_cache_tick;
+
+    return &entry->key_conf.ms_conf;
+}
+
+// Resolve multisynth config for given ratio from precalculated table, cache or solver
+static const si5351_ms_config_t* si5351_get_ms_config(si5351_dev *dev, si5351_clk_src clksrc, uint32_t clkin_hz, uint32_t mult_numer, uint32_t mult_denom, si5351_ms_config_t *ms_conf_gen) {
+    const si5351_ms_config_t *ms_conf;
+    uint32_t clksrc_hz, frac_gcd;
+    int retval;
+
+    if (!mult_numer || !mult_denom) {
+        printf("ERROR: Si5351 invalid frac mult or freq range exceeded\n\n");
+        return NULL;
+    }
+
+    clksrc_hz = (clksrc == SI_CLKIN) ? clkin_hz : dev->xtal_freq;
+    frac_gcd = gcd(mult_numer, mult_denom);
+    mult_numer /= frac_gcd;
+    mult_denom /= frac_gcd;
+
+    ms_conf = si5351_lookup_ms_config(dev, clksrc, clksrc_hz, mult_numer, mult_denom);
+    if (ms_conf) {
+        dev->stats.cache_hits++;
+        return ms_conf;
+    }
+
+    dev->stats.solves++;
+    retval = si5351_calc_frac_mult(clksrc, clksrc_hz, mult_numer, mult_denom, ms_conf_gen, &dev->frac_err_ppb);
+    if (retval == -1) {
+        printf("ERROR: Si5351 invalid frac mult or freq range exceeded\n\n");
+        return NULL;
+    } else if (retval < 0) {
+        printf("ERROR: Si5351 no valid multisynth config for %lu/%lu\n\n", mult_numer, mult_denom);
+        return NULL;
+    } else if (retval == 1) {
+        printf("Si5351 approximated feedback fraction, error %ldppb\n", dev->frac_err_ppb);
+    }
 
-        printf("Si5351 VCO freq: %luMHz (srcdiv=%u) (ms_a=%lu)\n\n", (clkout_hz*ms_a)/1000000, clkin_div, ms_a);
-        printf("Si5351 generated ms params msn_a=%lu, msn_b=%lu, msn_c=%lu, ms_a=%lu\n", msn_a, msn_b, msn_c, ms_a);
-        printf("Si5351 generated cfg: %lu, %lu, %lu,  %lu, %lu, %lu,  %u, %u, %u\n\n", ms_conf_gen.msn_p1, ms_conf_gen.msn_p2, ms_conf_gen.msn_p3,
-                                                                                       ms_conf_gen.ms_p1, ms_conf_gen.ms_p2, ms_conf_gen.ms_p3,
-                                                                                       ms_conf_gen.clkin_div_regval, ms_conf_gen.clkin_div_regval, ms_conf_gen.divby4);
+    printf("Si5351 generated cfg: %lu, %lu, %lu,  %lu, %lu, %lu,  %u, %u, %u\n\n", ms_conf_gen->msn_p1, ms_conf_gen->msn_p2, ms_conf_gen->msn_p3,
+                                                                                   ms_conf_gen->ms_p1, ms_conf_gen->ms_p2, ms_conf_gen->ms_p3,
+                                                                                   ms_conf_gen->clkin_div_regval, ms_conf_gen->outdiv, ms_conf_gen->divby4);
 
-        ms_conf = &ms_conf_gen;
+    return si5351_cache_ms_config(dev, clksrc, clksrc_hz, mult_numer, mult_denom, ms_conf_gen);
+}
+
+// Glitch behavior of frequency changes:
+//   - output multisynth / R divider change only: hitless for other outputs, PLL is not reset
+//   - PLL source, CLKIN divider or feedback multisynth change: PLL reset, all outputs on the PLL glitch
+//   - si5351_trim_pll(): hitless, no reset or output disable
+//   - si5351_set_frac_mult_pingpong(): active PLL and its other outputs untouched, output switched with a single
+//     CLKx_CTRL write. Not available (returns -1) if the output multisynth cannot be kept.
+int si5351_set_frac_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch out_ch, si5351_clk_src clksrc, uint32_t clkin_hz, uint32_t mult_numer, uint32_t mult_denom, const si5351_ms_config_t *ms_conf) {
+    si5351_ms_config_t ms_conf_gen;
+    si5351_pll_msn_config_t pll_msn_config;
+    si5351_out_ms_config_t out_ms_config;
+    int pll_rst_needed;
+
+    if (si5351_check_ready(dev) < 0)
+        return -1;
+
+    // Use precalculated or cached multisynth config if one is not given, and generate it as last resort
+    if (!ms_conf) {
+        ms_conf = si5351_get_ms_config(dev, clksrc, clkin_hz, mult_numer, mult_denom, &ms_conf_gen);
+        if (!ms_conf)
+            return -1;
+    } else {
+        dev->frac_err_ppb = 0;
     }
 
     //set PLL source and clockdiv
-    si5351_configure_pll(dev, pll_ch, clksrc, ms_conf->clkin_div_regval);
+    pll_rst_needed = si5351_configure_pll(dev, pll_ch, clksrc, ms_conf->clkin_div_regval);
 
     // set PLL and output multisynth
     pll_msn_config.p1 = ms_conf->msn_p1;
     pll_msn_config.p2 = ms_conf->msn_p2;
     pll_msn_config.p3 = ms_conf->msn_p3;
-    pll_rst_needed = si5351_set_pll_fb_multisynth(dev, pll_ch, &pll_msn_config);
+    pll_rst_needed |= si5351_set_pll_fb_multisynth(dev, pll_ch, &pll_msn_config);
     out_ms_config.p1 = ms_conf->ms_p1;
     out_ms_config.p2 = ms_conf->ms_p2;
     out_ms_config.p3 = ms_conf->ms_p3;
     out_ms_config.divby4 = ms_conf->divby4;
-    pll_rst_needed |= si5351_set_output_multisynth(dev, out_ch, &out_ms_config);
+    si5351_set_output_multisynth(dev, out_ch, &out_ms_config);
 
     // Set MS & output source clocks and power up output clock driver
     si5351_configure_clk(dev, pll_ch, out_ch, clksrc, 0);
 
-    // Reset PLL to prevent occasional lockup
+    // Reset PLL to prevent occasional lockup. Only done when PLL input or feedback changed, so that output-only
+    // retune does not glitch other outputs sharing the PLL.
     if (pll_rst_needed)
         si5351_pll_reset(dev, pll_ch);
 
@@ -375,6 +818,568 @@ int si5351_set_frac_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch ou
     return 0;
 }
 
+// Feedback config for the idle PLL which gives clksrc_hz*mult_numer/mult_denom through the current multisynth and
+// R divider of out_ch, so that the PLL switch needs only a CLKx_CTRL write. Returns -1 if not possible.
+static int si5351_calc_pingpong_msn(si5351_dev *dev, si5351_out_ch out_ch, uint32_t clksrc_hz, uint8_t clkin_div_regval, uint8_t outdiv, uint32_t mult_numer, uint32_t mult_denom, si5351_pll_msn_config_t *msn, int32_t *err_ppb) {
+    const si5351_out_ms_config_t *ms = &dev->out_ms_config[out_ch];
+    uint64_t num, den, g;
+    uint32_t pfd_hz, vco_hz, a, b, c;
+
+    if ((out_ch >= SI_CLK6) || (!ms->divby4 && (ms->p3 == 0)))
+        return -1;
+
+    // Feedback ratio = clkin_div * ms * R * mult_numer/mult_denom
+    if (ms->divby4) {
+        num = 4;
+        den = 1;
+    } else {
+        num = ((uint64_t)ms->p1+512)*ms->p3 + ms->p2;
+        den = 128*(uint64_t)ms->p3;
+    }
+    num <<= (clkin_div_regval + outdiv);
+
+    g = si5351_gcd64(num, mult_denom);
+    num /= g;
+    mult_denom /= g;
+    g = si5351_gcd64(den, mult_numer);
+    den /= g;
+    mult_numer /= g;
+
+    if ((num > 0xffffffffffffffffULL / mult_numer) || (den > 0xffffffffffffffffULL / mult_denom))
+        return -1;
+    num *= mult_numer;
+    den *= mult_denom;
+
+    *err_ppb = si5351_plan_frac(num, den, &a, &b, &c);
+    if ((a < 15) || (a > 90) || ((a == 90) && b))
+        return -1;
+
+    pfd_hz = clksrc_hz >> clkin_div_regval;
+    vco_hz = pfd_hz*a + (uint32_t)(((uint64_t)pfd_hz*b)/c);
+    if ((vco_hz < SI_VCO_MIN_FREQ) || (vco_hz > SI_VCO_MAX_FREQ))
+        return -1;
+
+    msn->p1 = 128*a + ((128*b)/c) - 512;
+    msn->p2 = 128*b - c*((128*b)/c);
+    msn->p3 = c;
+
+    return 0;
+}
+
+// Start frequency change of out_ch without output dropout. The idle PLL (not feeding out_ch) is tuned for the current
+// multisynth and R divider of out_ch and reset while the output keeps running from the active PLL, whose other outputs
+// are untouched. Switch is completed by si5351_pingpong_poll() with a single CLKx_CTRL write once the PLL has locked.
+// Returns PLL used for new plan, or -1 without touching the device if the switch cannot be done glitch-free (output
+// multisynth would need to change or would be less accurate than the nominal plan, idle PLL or CLKIN divider in use),
+// in which case caller should use si5351_set_frac_mult().
+int si5351_set_frac_mult_pingpong(si5351_dev *dev, si5351_out_ch out_ch, si5351_clk_src clksrc, uint32_t clkin_hz, uint32_t mult_numer, uint32_t mult_denom, const si5351_ms_config_t *ms_conf) {
+    si5351_ms_config_t ms_conf_gen;
+    si5351_pll_msn_config_t pll_msn_config;
+    si5351_pingpong_t *pp = &dev->pingpong;
+    si5351_pll_ch pll_ch;
+    uint8_t clk_ctrl[8], pll_src, outdiv;
+    int32_t err, frac_err;
+    int i;
+
+    if (si5351_check_ready(dev) < 0)
+        return -1;
+
+    if (!ms_conf) {
+        ms_conf = si5351_get_ms_config(dev, clksrc, clkin_hz, mult_numer, mult_denom, &ms_conf_gen);
+        if (!ms_conf)
+            return -1;
+    } else {
+        dev->frac_err_ppb = 0;
+    }
+
+    // Prepare plan on PLL not currently feeding the output
+    si5351_readregs(dev, SI5351_CLK0_CTRL, clk_ctrl, 8);
+    pll_ch = (clk_ctrl[out_ch] & (1<<5)) ? SI_PLLA : SI_PLLB;
+
+    // Idle PLL must not feed any other active output
+    for (i=SI_CLK0; i<=SI_CLK7; i++) {
+        if ((i != out_ch) && !(clk_ctrl[i] & (1<<7)) && (((clk_ctrl[i] >> 5) & 1) == pll_ch)) {
+            printf("ERROR: Si5351 PLL%c in use by CLK%d\n\n", 'A'+pll_ch, i);
+            return -1;
+        }
+    }
+
+    // CLKIN divider is shared between PLLs
+    pll_src = si5351_readreg(dev, SI5351_PLL_SRC);
+    if ((clksrc == SI_CLKIN) && (pll_src & (1<<(2+(1-pll_ch)))) && ((pll_src >> 6) != ms_conf->clkin_div_regval)) {
+        printf("ERROR: Si5351 CLKIN divider conflict with active PLL\n\n");
+        return -1;
+    }
+
+    if (out_ch < SI_CLK6)
+        outdiv = (si5351_readreg(dev, SI5351_MS0_BASE+out_ch*8+2) >> 4) & 0x7;
+    else
+        outdiv = (si5351_readreg(dev, SI5351_CLK6_7_OUTDIV) >> (4*(out_ch-SI_CLK6))) & 0x7;
+
+    // Output multisynth must be kept, and not be less accurate than the nominal plan. Rewriting it while the output
+    // still runs from the old PLL would briefly output a wrong frequency.
+    frac_err = (dev->frac_err_ppb < 0) ? -dev->frac_err_ppb : dev->frac_err_ppb;
+    if ((si5351_calc_pingpong_msn(dev, out_ch, (clksrc == SI_CLKIN) ? clkin_hz : dev->xtal_freq, (clksrc == SI_CLKIN) ? ms_conf->clkin_div_regval : 0,
+                                  outdiv, mult_numer, mult_denom, &pll_msn_config, &err) != 0) ||
+        (((err < 0) ? -err : err) > frac_err))
+    {
+        printf("Si5351 CLK%d multisynth cannot be kept, ping-pong switch not possible\n\n", out_ch);
+        return -1;
+    }
+    dev->frac_err_ppb = err;
+
+    memset(pp, 0, sizeof(si5351_pingpong_t));
+    pp->out_ch = out_ch;
+    pp->pll_ch = pll_ch;
+
+    si5351_configure_pll(dev, pll_ch, clksrc, ms_conf->clkin_div_regval);
+    si5351_set_pll_fb_multisynth(dev, pll_ch, &pll_msn_config);
+    si5351_pll_reset(dev, pll_ch);
+    pp->pending = 1;
+
+    return pll_ch;
+}
+
+// Complete PLL switch started by si5351_set_frac_mult_pingpong(). Only SI5351_DEV_STATUS is read so that latched
+// events are left for si5351_poll(). Returns 1 while waiting for lock, 0 when switched (or nothing pending) and
+// -1 on lock timeout in which case the output stays on the previous PLL.
+int si5351_pingpong_poll(si5351_dev *dev) {
+    si5351_pingpong_t *pp = &dev->pingpong;
+    uint8_t status, lol_bit, clk_ctrl;
+
+    if (!pp->pending)
+        return 0;
+
+    lol_bit = (pp->pll_ch == SI_PLLA) ? SI_STATUS_LOL_A : SI_STATUS_LOL_B;
+    status = si5351_readreg(dev, SI5351_DEV_STATUS);
+
+    if (status & (SI_STATUS_SYS_INIT|lol_bit)) {
+        if (++pp->polls >= SI_LOCK_TIMEOUT_POLLS) {
+            printf("ERROR: Si5351 PLL%c lock timeout, CLK%d not switched\n\n", 'A'+pp->pll_ch, pp->out_ch);
+            pp->pending = 0;
+            return -1;
+        }
+        return 1;
+    }
+
+    if ((dev->state == SI_STATE_LOCKING) && !(status & dev->lol_mask))
+        dev->state = SI_STATE_READY;
+
+    clk_ctrl = si5351_readreg(dev, SI5351_CLK0_CTRL+pp->out_ch);
+    clk_ctrl &= ~((1<<7)|(1<<5)|(3<<2));
+    clk_ctrl |= (pp->pll_ch<<5)|(3<<2)|3;
+
+    // Source switch in a single write
+    si5351_writereg(dev, SI5351_CLK0_CTRL+pp->out_ch, clk_ctrl);
+    si5351_enable_output(dev, pp->out_ch);
+    pp->pending = 0;
+
+    return 0;
+}
+
+int si5351_trim_pll(si5351_dev *dev, si5351_pll_ch pll_ch, int32_t trim_ppb) {
+    si5351_pll_msn_config_t cfg;
+    const si5351_pll_msn_config_t *nom = &dev->pll_msn_nominal[pll_ch];
+    uint8_t regs_old[8], regs_new[8];
+    uint8_t fb_int_reg;
+    uint64_t num;
+    uint32_t c;
+    int first, last, fb_int_old, fb_int_new;
+
+    if ((nom->p3 == 0) || (trim_ppb < -SI_TRIM_MAX_PPB) || (trim_ppb > SI_TRIM_MAX_PPB))
+        return -1;
+
+    // Scale denominator close to 20-bit limit for sub-ppb resolution. Depends only on nominal config so that
+    // consecutive trims leave P3 intact and typically only touch P2 bytes.
+    c = nom->p3;
+    if (c < (1UL<<19))
+        c *= (1048575UL / c);
+
+    // Feedback ratio in units of 1/(128*c)
+    num = ((uint64_t)nom->p1+512)*c + ((uint64_t)nom->p2*(c/nom->p3));
+    if (trim_ppb > 0)
+        num += (num*trim_ppb + 500000000UL) / 1000000000UL;
+    else
+        num -= (num*(-trim_ppb) + 500000000UL) / 1000000000UL;
+
+    if ((num < 15*128*(uint64_t)c) || (num > 90*128*(uint64_t)c))
+        return -1;
+
+    cfg.p1 = (num / c) - 512;
+    cfg.p2 = num % c;
+    cfg.p3 = c;
+
+    fb_int_old = si5351_ms_is_int(dev->pll_msn_config[pll_ch].p1, dev->pll_msn_config[pll_ch].p2);
+    fb_int_new = si5351_ms_is_int(cfg.p1, cfg.p2);
+
+    // Integer mode must be dropped before trimming away from integer ratio
+    if (fb_int_old && !fb_int_new) {
+        fb_int_reg = si5351_readreg(dev, SI5351_CLK6_CTRL+pll_ch);
+        si5351_writereg(dev, SI5351_CLK6_CTRL+pll_ch, fb_int_reg & ~(1<<6));
+    }
+
+    // Write changed registers in a single burst, without output disable or PLL reset
+    si5351_get_msn_regs(&dev->pll_msn_config[pll_ch], regs_old);
+    si5351_get_msn_regs(&cfg, regs_new);
+
+    for (first=0; (first<8) && (regs_old[first] == regs_new[first]); first++) ;
+    for (last=7; (last>first) && (regs_old[last] == regs_new[last]); last--) ;
+
+    if (first < 8)
+        si5351_writeregs(dev, SI5351_MSNA_BASE+pll_ch*8+first, regs_new+first, last-first+1);
+
+    // ...and restored once back at an even integer ratio
+    if (!fb_int_old && fb_int_new) {
+        fb_int_reg = si5351_readreg(dev, SI5351_CLK6_CTRL+pll_ch);
+        si5351_writereg(dev, SI5351_CLK6_CTRL+pll_ch, fb_int_reg | (1<<6));
+    }
+
+    memcpy(&dev->pll_msn_config[pll_ch], &cfg, sizeof(si5351_pll_msn_config_t));
+
+    return 0;
+}
+
+typedef struct {
+    uint64_t err;
+    uint8_t frac_ms;
+    uint8_t frac_fb;
+    uint32_t vco_dist;
+} si5351_plan_cost_t;
+
+static int si5351_plan_cost_lt(const si5351_plan_cost_t *a, const si5351_plan_cost_t *b) {
+    if (a->err != b->err)
+        return a->err < b->err;
+    if (a->frac_ms != b->frac_ms)
+        return a->frac_ms < b->frac_ms;
+    if (a->frac_fb != b->frac_fb)
+        return a->frac_fb < b->frac_fb;
+    return a->vco_dist < b->vco_dist;
+}
+
+// Plan outputs in out_mask onto a single PLL. Each output in turn is tried as primary which gets an integer output
+// divider, and the others are derived from the resulting VCO frequency. Returns -1 if no valid plan exists.
+static int si5351_plan_pll(const si5351_out_req_t *req, uint8_t out_mask, uint32_t src_hz, uint8_t clkin_div, si5351_pll_ch pll_ch, si5351_plan_t *plan, si5351_plan_cost_t *cost) {
+    si5351_plan_t cand;
+    si5351_plan_cost_t cand_cost;
+    uint64_t num, den, g1, g2;
+    uint32_t out_hz, vco_hz, ms_a, ms_a_min, ms_a_max, k, d, msn_a, msn_b, msn_c, a, b, c, frac_gcd;
+    int32_t fb_err, err;
+    int i, p, found = 0;
+
+    for (p=SI_CLK0; p<=SI_CLK7; p++) {
+        if (!(out_mask & (1<<p)))
+            continue;
+
+        out_hz = ((uint64_t)src_hz*req[p].mult_numer)/req[p].mult_denom;
+        if ((out_hz == 0) || (out_hz > SI_MAX_OUTPUT_FREQ))
+            continue;
+
+        if (out_hz >= 150000000UL) {
+            if (p >= SI_CLK6)
+                continue;
+            ms_a_min = ms_a_max = 4;
+        } else {
+            ms_a_min = ((SI_VCO_MIN_FREQ / out_hz) + 1) & ~1;
+            ms_a_max = (SI_VCO_MAX_FREQ / out_hz) & ~1;
+            if (ms_a_min < 6)
+                ms_a_min = 6;
+            if (ms_a_max > ((p >= SI_CLK6) ? 254 : 2046))
+                ms_a_max = (p >= SI_CLK6) ? 254 : 2046;
+        }
+
+        for (ms_a=ms_a_min; ms_a<=ms_a_max; ms_a+=2) {
+            memset(&cand_cost, 0, sizeof(si5351_plan_cost_t));
+
+            // Feedback multisynth for primary output
+            k = clkin_div*ms_a;
+            frac_gcd = gcd(k, req[p].mult_denom);
+            k /= frac_gcd;
+            d = req[p].mult_denom / frac_gcd;
+            num = (uint64_t)req[p].mult_numer*k;
+            if ((num < 15*(uint64_t)d) || (num > 90*(uint64_t)d))
+                continue;
+
+            fb_err = si5351_plan_frac(num, d, &msn_a, &msn_b, &msn_c);
+            if ((msn_a < 15) || (msn_a > 90) || ((msn_a == 90) && msn_b))
+                continue;
+
+            vco_hz = (src_hz/clkin_div)*msn_a + (uint32_t)(((uint64_t)(src_hz/clkin_div)*msn_b)/msn_c);
+            if ((vco_hz < SI_VCO_MIN_FREQ) || (vco_hz > SI_VCO_MAX_FREQ))
+                continue;
+
+            cand.pll_msn_config[pll_ch].p1 = 128*msn_a + ((128*msn_b)/msn_c) - 512;
+            cand.pll_msn_config[pll_ch].p2 = 128*msn_b - msn_c*((128*msn_b)/msn_c);
+            cand.pll_msn_config[pll_ch].p3 = msn_c;
+            cand_cost.frac_fb = (msn_b != 0) || (msn_a % 2);
+            cand_cost.vco_dist = (vco_hz > SI_VCO_CENTER_FREQ) ? (vco_hz - SI_VCO_CENTER_FREQ) : (SI_VCO_CENTER_FREQ - vco_hz);
+
+            // Output multisynths: ms_i = ms_a * (numer_p/denom_p) / (numer_i/denom_i)
+            for (i=SI_CLK0; i<=SI_CLK7; i++) {
+                if (!(out_mask & (1<<i)))
+                    continue;
+
+                g1 = si5351_gcd64(req[p].mult_numer, req[i].mult_numer);
+                g2 = si5351_gcd64(req[p].mult_denom, req[i].mult_denom);
+                num = (uint64_t)(req[p].mult_numer/g1) * (req[i].mult_denom/g2);
+                den = (uint64_t)(req[p].mult_denom/g2) * (req[i].mult_numer/g1);
+                if (num > 0xffffffffffffffffULL / ms_a)
+                    break;
+                num *= ms_a;
+
+                err = si5351_plan_frac(num, den, &a, &b, &c);
+
+                memset(&cand.out_ms_config[i], 0, sizeof(si5351_out_ms_config_t));
+                if ((a == 4) && (b == 0) && (i < SI_CLK6)) {
+                    cand.out_ms_config[i].divby4 = 3;
+                } else if (i >= SI_CLK6) {
+                    if (b || (a % 2) || (a < 6) || (a > 254))
+                        break;
+                    cand.out_ms_config[i].p1 = a;
+                } else {
+                    // Valid ratios are 4 (DIVBY4), 6, 8 and any value from 8 to 2048
+                    if (((a < 8) && !((a == 6) && !b)) || (a > 2048) || ((a == 2048) && b))
+                        break;
+                    cand.out_ms_config[i].p1 = 128*a + ((128*b)/c) - 512;
+                    cand.out_ms_config[i].p2 = 128*b - c*((128*b)/c);
+                }
+                cand.out_ms_config[i].p3 = c;
+                cand.out_pll[i] = pll_ch;
+                cand.err_ppb[i] = si5351_chain_err_ppb(fb_err, err);
+
+                cand_cost.err += (cand.err_ppb[i] < 0) ? -cand.err_ppb[i] : cand.err_ppb[i];
+                cand_cost.frac_ms += (b != 0) || (a % 2);
+            }
+
+            if (i < 8)
+                continue;
+
+            if (!found || si5351_plan_cost_lt(&cand_cost, cost)) {
+                memcpy(&plan->pll_msn_config[pll_ch], &cand.pll_msn_config[pll_ch], sizeof(si5351_pll_msn_config_t));
+                for (i=SI_CLK0; i<=SI_CLK7; i++) {
+                    if (out_mask & (1<<i)) {
+                        memcpy(&plan->out_ms_config[i], &cand.out_ms_config[i], sizeof(si5351_out_ms_config_t));
+                        plan->out_pll[i] = pll_ch;
+                        plan->err_ppb[i] = cand.err_ppb[i];
+                    }
+                }
+                memcpy(cost, &cand_cost, sizeof(si5351_plan_cost_t));
+                found = 1;
+            }
+        }
+    }
+
+    return found ? 0 : -1;
+}
+
+// Jointly plan all requested outputs (frequency = src_hz*mult_numer/mult_denom) over both PLLs. Every PLL
+// assignment is evaluated, minimizing total frequency error, then fractional output and feedback dividers,
+// then VCO distance from center.
+int si5351_calc_plan(const si5351_out_req_t *req, uint32_t xtal_hz, uint32_t clkin_hz, si5351_plan_t *plan) {
+    si5351_plan_t cand;
+    si5351_plan_cost_t cost, pll_cost, best_cost;
+    uint32_t src_hz[2];
+    uint8_t used_ch[8], group_mask[2], clkin_div = 1;
+    int i, n = 0, found = 0;
+    unsigned assign;
+    si5351_pll_ch pll_ch;
+
+    memset(plan, 0, sizeof(si5351_plan_t));
+    memset(&cand, 0, sizeof(si5351_plan_t));
+
+    for (i=SI_CLK0; i<=SI_CLK7; i++) {
+        if (req[i].mult_numer && req[i].mult_denom)
+            used_ch[n++] = i;
+    }
+
+    if (n == 0)
+        return 0;
+
+    // CLKIN divider is shared between PLLs, keep PFD within range
+    if (clkin_hz) {
+        while ((clkin_hz/clkin_div > SI_CLKIN_MAX_FREQ) && (clkin_div < 8))
+            clkin_div *= 2;
+        cand.clkin_div_regval = (clkin_div == 8) ? 3 : clkin_div/2;
+    }
+
+    // First used output is always on PLLA to skip mirrored assignments
+    for (assign=0; assign<(1U<<(n-1)); assign++) {
+        group_mask[SI_PLLA] = group_mask[SI_PLLB] = 0;
+        for (i=0; i<n; i++)
+            group_mask[(i > 0) && (assign & (1<<(i-1)))] |= (1<<used_ch[i]);
+
+        memset(&cost, 0, sizeof(si5351_plan_cost_t));
+
+        for (pll_ch=SI_PLLA; pll_ch<=SI_PLLB; pll_ch++) {
+            if (!group_mask[pll_ch])
+                continue;
+
+            // All outputs on a PLL must share its reference
+            for (i=0; !(group_mask[pll_ch] & (1<<i)); i++) ;
+            cand.pll_src[pll_ch] = req[i].clksrc;
+            for (; i<8; i++) {
+                if ((group_mask[pll_ch] & (1<<i)) && (req[i].clksrc != cand.pll_src[pll_ch]))
+                    break;
+            }
+            if (i < 8)
+                break;
+
+            src_hz[pll_ch] = (cand.pll_src[pll_ch] == SI_CLKIN) ? clkin_hz : xtal_hz;
+            if ((src_hz[pll_ch] < SI_CLKIN_MIN_FREQ) ||
+                (si5351_plan_pll(req, group_mask[pll_ch], src_hz[pll_ch], (cand.pll_src[pll_ch] == SI_CLKIN) ? clkin_div : 1, pll_ch, &cand, &pll_cost) != 0))
+                break;
+
+            cost.err += pll_cost.err;
+            cost.frac_ms += pll_cost.frac_ms;
+            cost.frac_fb += pll_cost.frac_fb;
+            cost.vco_dist += pll_cost.vco_dist;
+        }
+
+        if (pll_ch <= SI_PLLB)
+            continue;
+
+        cand.pll_used = (group_mask[SI_PLLA] ? (1<<SI_PLLA) : 0) | (group_mask[SI_PLLB] ? (1<<SI_PLLB) : 0);
+        cand.out_used = group_mask[SI_PLLA] | group_mask[SI_PLLB];
+
+        if (!found || si5351_plan_cost_lt(&cost, &best_cost)) {
+            memcpy(plan, &cand, sizeof(si5351_plan_t));
+            memcpy(&best_cost, &cost, sizeof(si5351_plan_cost_t));
+            found = 1;
+        }
+    }
+
+    return found ? 0 : -1;
+}
+
+// Program a plan from si5351_calc_plan() with a fixed write order: PLL source, multisynth block, clock controls,
+// PLL reset (only for PLLs whose input or feedback changed) and output enables. Only registers of used PLLs and
+// planned outputs are written, everything else (including R dividers of other outputs) keeps its current state.
+// Returns -1 without touching the device if init has not completed.
+int si5351_apply_plan(si5351_dev *dev, const si5351_plan_t *plan) {
+    uint8_t ms_regs[SI5351_CLK6_7_OUTDIV-SI5351_MSNA_BASE+1];
+    uint8_t ms_dirty[SI5351_CLK6_7_OUTDIV-SI5351_MSNA_BASE+1];
+    uint8_t clk_ctrl[8];
+    uint8_t pll_src, prev_pll_src, pll_rst = 0, lol_mask = 0, oen;
+    const si5351_pll_msn_config_t *msn;
+    const si5351_out_ms_config_t *ms;
+    si5351_pll_ch pll_ch;
+    uint8_t *regs;
+    int i, first;
+
+    if (si5351_check_ready(dev) < 0)
+        return -1;
+
+    memset(ms_dirty, 0, sizeof(ms_dirty));
+
+    // PLL source and shared CLKIN divider
+    prev_pll_src = si5351_readreg(dev, SI5351_PLL_SRC);
+    pll_src = prev_pll_src;
+    for (pll_ch=SI_PLLA; pll_ch<=SI_PLLB; pll_ch++) {
+        if (plan->pll_used & (1<<pll_ch)) {
+            pll_src &= ~(1<<(2+pll_ch));
+            pll_src |= (plan->pll_src[pll_ch]<<(2+pll_ch));
+            if (plan->pll_src[pll_ch] == SI_CLKIN) {
+                pll_src &= ~(3<<6);
+                pll_src |= (plan->clkin_div_regval<<6);
+            }
+        }
+    }
+    if (pll_src != prev_pll_src)
+        si5351_writereg(dev, SI5351_PLL_SRC, pll_src);
+
+    // Clock controls are read back as FB_INT bits and controls of unplanned outputs must be preserved
+    si5351_readregs(dev, SI5351_CLK0_CTRL, clk_ctrl, 8);
+
+    // Feedback multisynths of used PLLs
+    for (pll_ch=SI_PLLA; pll_ch<=SI_PLLB; pll_ch++) {
+        if (!(plan->pll_used & (1<<pll_ch)))
+            continue;
+
+        msn = &plan->pll_msn_config[pll_ch];
+        si5351_get_msn_regs(msn, ms_regs + pll_ch*8);
+        memset(ms_dirty + pll_ch*8, 1, 8);
+
+        // FB_INT bits reside in CLK6/CLK7 control registers
+        clk_ctrl[SI_CLK6+pll_ch] &= ~(1<<6);
+        if (si5351_ms_is_int(msn->p1, msn->p2))
+            clk_ctrl[SI_CLK6+pll_ch] |= (1<<6);
+
+        if (memcmp(&dev->pll_msn_config[pll_ch], msn, sizeof(si5351_pll_msn_config_t)) ||
+            (((pll_src ^ prev_pll_src) & ((1<<(2+pll_ch))|(3<<6))) != 0))
+        {
+            pll_rst |= (1<<(5+2*pll_ch));
+            lol_mask |= (pll_ch == SI_PLLA) ? SI_STATUS_LOL_A : SI_STATUS_LOL_B;
+        }
+    }
+
+    // Output multisynths of planned outputs, R divider is set to 1 as the plan assumes no output division
+    if (plan->out_used & ((1<<SI_CLK6)|(1<<SI_CLK7)))
+        ms_regs[SI5351_CLK6_7_OUTDIV-SI5351_MSNA_BASE] = si5351_readreg(dev, SI5351_CLK6_7_OUTDIV);
+
+    for (i=SI_CLK0; i<=SI_CLK7; i++) {
+        if (!(plan->out_used & (1<<i)))
+            continue;
+
+        ms = &plan->out_ms_config[i];
+
+        if (i < SI_CLK6) {
+            regs = ms_regs + (SI5351_MS0_BASE-SI5351_MSNA_BASE) + i*8;
+            regs[0] = (ms->p3 >> 8) & 0xff;
+            regs[1] = (ms->p3 & 0xff);
+            regs[2] = (ms->divby4<<2) | ((ms->p1 >> 16) & 0x3);
+            regs[3] = (ms->p1 >> 8) & 0xff;
+            regs[4] = (ms->p1 & 0xff);
+            regs[5] = (((ms->p3 >> 16) & 0xf) << 4) | ((ms->p2 >> 16) & 0xf);
+            regs[6] = (ms->p2 >> 8) & 0xff;
+            regs[7] = (ms->p2 & 0xff);
+            memset(ms_dirty + (SI5351_MS0_BASE-SI5351_MSNA_BASE) + i*8, 1, 8);
+        } else {
+            ms_regs[SI5351_MS6-SI5351_MSNA_BASE+(i-SI_CLK6)] = ms->p1;
+            ms_dirty[SI5351_MS6-SI5351_MSNA_BASE+(i-SI_CLK6)] = 1;
+            ms_regs[SI5351_CLK6_7_OUTDIV-SI5351_MSNA_BASE] &= ~(7<<(4*(i-SI_CLK6)));
+            ms_dirty[SI5351_CLK6_7_OUTDIV-SI5351_MSNA_BASE] = 1;
+        }
+
+        clk_ctrl[i] &= (i >= SI_CLK6) ? (1<<6) : 0;
+        clk_ctrl[i] |= (plan->out_pll[i]<<5)|(3<<2)|3;
+        if ((i < SI_CLK6) && (ms->divby4 || si5351_ms_is_int(ms->p1, ms->p2)))
+            clk_ctrl[i] |= (1<<6);
+    }
+
+    // Write contiguous runs of updated registers as bursts
+    for (i=0, first=-1; i<=(int)sizeof(ms_regs); i++) {
+        if ((i < (int)sizeof(ms_regs)) && ms_dirty[i]) {
+            if (first < 0)
+                first = i;
+        } else if (first >= 0) {
+            si5351_writeregs(dev, SI5351_MSNA_BASE+first, ms_regs+first, i-first);
+            first = -1;
+        }
+    }
+    si5351_writeregs(dev, SI5351_CLK0_CTRL, clk_ctrl, 8);
+
+    if (pll_rst) {
+        si5351_writereg(dev, SI5351_PLL_RESET, pll_rst);
+        si5351_lock_start(dev, lol_mask);
+    }
+
+    oen = si5351_readreg(dev, SI5351_OEN_CTRL);
+    if (oen & plan->out_used)
+        si5351_writereg(dev, SI5351_OEN_CTRL, oen & ~plan->out_used);
+
+    for (pll_ch=SI_PLLA; pll_ch<=SI_PLLB; pll_ch++) {
+        if (plan->pll_used & (1<<pll_ch)) {
+            memcpy(&dev->pll_msn_config[pll_ch], &plan->pll_msn_config[pll_ch], sizeof(si5351_pll_msn_config_t));
+            memcpy(&dev->pll_msn_nominal[pll_ch], &plan->pll_msn_config[pll_ch], sizeof(si5351_pll_msn_config_t));
+        }
+    }
+    for (i=SI_CLK0; i<=SI_CLK7; i++) {
+        if (plan->out_used & (1<<i))
+            memcpy(&dev->out_ms_config[i], &plan->out_ms_config[i], sizeof(si5351_out_ms_config_t));
+    }
+
+    return 0;
+}
+
 int si5351_set_integer_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch out_ch, si5351_clk_src clksrc, uint32_t clkin_hz, uint8_t mult, uint8_t outdiv) {
     si5351_pll_msn_config_t pll_msn_config;
     si5351_out_ms_config_t out_ms_config;
@@ -384,6 +1389,9 @@ int si5351_set_integer_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch
     uint8_t optim_ratio;
     int pll_rst_needed;
 
+    if (si5351_check_ready(dev) < 0)
+        return -1;
+
     clksrc_hz = (clksrc == SI_CLKIN) ? clkin_hz : dev->xtal_freq;
 
     if ((mult == 0) || (clksrc_hz < SI_CLKIN_MIN_FREQ) || (clksrc_hz*mult > SI_MAX_OUTPUT_FREQ)) {
@@ -408,7 +1416,7 @@ int si5351_set_integer_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch
         }
 
         //set PLL source and clockdiv
-        si5351_configure_pll(dev, pll_ch, clksrc, clkin_div_regval);
+        pll_rst_needed = si5351_configure_pll(dev, pll_ch, clksrc, clkin_div_regval);
 
         //use even fbdiv for lowest jitter
         optim_ratio = 2*clkin_div*mult;
@@ -432,7 +1440,7 @@ int si5351_set_integer_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch
         pll_msn_config.p1 = msn_p1;
         pll_msn_config.p2 = 0;
         pll_msn_config.p3 = 1;
-        pll_rst_needed = si5351_set_pll_fb_multisynth(dev, pll_ch, &pll_msn_config);
+        pll_rst_needed |= si5351_set_pll_fb_multisynth(dev, pll_ch, &pll_msn_config);
 
         // 6 and 8 seem to be ok in integer mode despite what AN619 4.1.2 implies
         if (ms_a == 4) {
@@ -445,7 +1453,7 @@ int si5351_set_integer_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch
         }
         out_ms_config.p2 = 0;
         out_ms_config.p3 = 1;
-        pll_rst_needed |= si5351_set_output_multisynth(dev, out_ch, &out_ms_config);
+        si5351_set_output_multisynth(dev, out_ch, &out_ms_config);
         printf("Si5351 VCO freq: %luMHz (srcdiv=%u) (msn_a=%lu) (ms_a=%lu)\n\n", (msn_a*(clksrc_hz/clkin_div))/1000000, clkin_div, msn_a, ms_a);
 
         // Set MS & output source clocks and power up output clock driver
@@ -473,22 +1481,97 @@ void si5351_disable_outputs(si5351_dev *dev, uint8_t out_ch_mask) {
     si5351_writereg(dev, SI5351_OEN_CTRL, acc_reg);
 }
 
-void si5351_init(si5351_dev *dev) {
-    int i;
-    uint8_t ret;
-
+void si5351_init_start(si5351_dev *dev) {
     memset(dev->pll_msn_config, 0x00, sizeof(dev->pll_msn_config));
+    memset(dev->pll_msn_nominal, 0x00, sizeof(dev->pll_msn_nominal));
     memset(dev->out_ms_config, 0x00, sizeof(dev->out_ms_config));
+    memset(dev->ms_cache, 0x00, sizeof(dev->ms_cache));
+    dev->ms_cache_tick = 0;
+    memset(&dev->stats, 0x00, sizeof(si5351_stats_t));
+    memset(&dev->pingpong, 0x00, sizeof(si5351_pingpong_t));
+
+    dev->state = SI_STATE_SYSINIT;
+    dev->lol_mask = 0;
+    dev->polls = 0;
+}
 
-    // Wait until Si5351 initialization is complete
-    while ((si5351_readreg(dev, 0x00) & 0x80) == 0x80) ;
+// Start waiting for lock of PLLs given as SI_STATUS_LOL_x mask. PLLs already being waited for stay tracked, and
+// the lock timeout restarts. Returns -1 if device has not completed init, in which case lock is not tracked.
+int si5351_lock_start(si5351_dev *dev, uint8_t lol_mask) {
+    if ((dev->state == SI_STATE_RESET) || (dev->state == SI_STATE_SYSINIT) || (dev->state == SI_STATE_INIT_FAILED))
+        return -1;
+
+    if (dev->state == SI_STATE_LOCKING)
+        dev->lol_mask |= lol_mask;
+    else
+        dev->lol_mask = lol_mask;
+    dev->state = SI_STATE_LOCKING;
+    dev->polls = 0;
+
+    return 0;
+}
+
+// Advance init / lock state machine. Should be called every SI_POLL_US or slower (timeouts are counted in polls).
+// Latched LOL_A/LOL_B/LOS events since previous call are returned via events (optional) and cleared.
+si5351_state si5351_poll(si5351_dev *dev, uint8_t *events) {
+    uint8_t status[2];
+    int i;
+
+    if (events)
+        *events = 0;
+
+    switch (dev->state) {
+    case SI_STATE_SYSINIT:
+        if (si5351_readreg(dev, SI5351_DEV_STATUS) & SI_STATUS_SYS_INIT) {
+            if (++dev->polls >= SI_SYSINIT_TIMEOUT_POLLS) {
+                printf("ERROR: Si5351 init timeout\n\n");
+                dev->state = SI_STATE_INIT_FAILED;
+            }
+            break;
+        }
 
-    for (i=0; i<SI5351C_REVB_REG_CONFIG_NUM_REGS; i++)
-        si5351_writereg(dev, si5351c_revb_registers[i].address, si5351c_revb_registers[i].value);
+        for (i=0; i<SI5351C_REVB_REG_CONFIG_NUM_REGS; i++)
+            si5351_writereg(dev, si5351c_revb_registers[i].address, si5351c_revb_registers[i].value);
+
+        // Clear events latched during power-up
+        si5351_writereg(dev, SI5351_IRQ_STATUS, 0x00);
+        dev->state = SI_STATE_READY;
+        break;
+    case SI_STATE_LOCKING:
+    case SI_STATE_READY:
+    case SI_STATE_LOCK_FAILED:
+        si5351_readregs(dev, SI5351_DEV_STATUS, status, 2);
+
+        // Sticky bits are cleared by writing 0
+        if (status[1] & SI_STATUS_EVT_MASK) {
+            if (events)
+                *events = status[1] & SI_STATUS_EVT_MASK;
+            si5351_writereg(dev, SI5351_IRQ_STATUS, ~status[1]);
+        }
+
+        if (dev->state == SI_STATE_LOCKING) {
+            if (!(status[0] & dev->lol_mask)) {
+                dev->state = SI_STATE_READY;
+            } else if (++dev->polls >= SI_LOCK_TIMEOUT_POLLS) {
+                printf("ERROR: Si5351 PLL lock timeout (status 0x%.2x)\n\n", status[0]);
+                dev->state = SI_STATE_LOCK_FAILED;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+
+    return dev->state;
+}
+
+// Blocking init. Returns 0 on success and -1 if device did not complete SYS_INIT in time.
+int si5351_init(si5351_dev *dev) {
+    si5351_init_start(dev);
+
+    // Wait until Si5351 initialization is complete
+    while (si5351_poll(dev, NULL) == SI_STATE_SYSINIT)
+        usleep(SI_POLL_US);
 
-    /*printf("Waiting PLL lock\n");
-    while (((ret = si5351_readreg(0x00)) & (7<<4)) != 0x00) {
-        printf("ret: 0x%.2x\n", ret);
-        usleep(1000000);
-    }*/
+    return (dev->state == SI_STATE_READY) ? 0 : -1;
 }
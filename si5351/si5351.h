@@ -26,10 +26,36 @@
 #include "si5351_regs.h"
 
 #define SI_VCO_CENTER_FREQ  750000000UL
+#define SI_VCO_MIN_FREQ     600000000UL
+#define SI_VCO_MAX_FREQ     900000000UL
 #define SI_CLKIN_MIN_FREQ   10000000UL
 #define SI_CLKIN_MAX_FREQ   40000000UL
 #define SI_MAX_OUTPUT_FREQ  300000000UL
 
+#define SI_MS_CACHE_SIZE    8
+#define SI_TRIM_MAX_PPB     1000000L
+
+#define SI_POLL_US                  100
+#define SI_SYSINIT_TIMEOUT_POLLS    1000
+#define SI_LOCK_TIMEOUT_POLLS       100
+
+// DEV_STATUS / IRQ_STATUS bits
+#define SI_STATUS_SYS_INIT  (1<<7)
+#define SI_STATUS_LOL_B     (1<<6)
+#define SI_STATUS_LOL_A     (1<<5)
+#define SI_STATUS_LOS_CLKIN (1<<4)
+#define SI_STATUS_LOS_XTAL  (1<<3)
+#define SI_STATUS_EVT_MASK  (SI_STATUS_LOL_B|SI_STATUS_LOL_A|SI_STATUS_LOS_CLKIN|SI_STATUS_LOS_XTAL)
+
+typedef enum {
+    SI_STATE_RESET = 0,
+    SI_STATE_SYSINIT,
+    SI_STATE_LOCKING,
+    SI_STATE_READY,
+    SI_STATE_INIT_FAILED,
+    SI_STATE_LOCK_FAILED
+} si5351_state;
+
 typedef enum {
     SI_XTAL = 0,
     SI_CLKIN
@@ -64,14 +90,6 @@ typedef struct {
     uint8_t divby4;
 } si5351_out_ms_config_t;
 
-typedef struct {
-    uint32_t i2cm_base;
-    uint8_t i2c_addr;
-    uint32_t xtal_freq;
-    si5351_pll_msn_config_t pll_msn_config[2];
-    si5351_out_ms_config_t out_ms_config[8];
-} si5351_dev;
-
 typedef struct {
     uint32_t msn_p1;
     uint32_t msn_p2;
@@ -84,12 +102,95 @@ typedef struct {
     uint8_t divby4;
 } si5351_ms_config_t;
 
-int si5351_set_frac_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch out_ch, si5351_clk_src clksrc, uint32_t clkin_hz, uint32_t mult_numer, uint32_t mult_denom, si5351_ms_config_t *ms_conf);
+typedef struct {
+    si5351_clk_src clksrc;
+    uint32_t clksrc_hz;
+    uint32_t mult_numer;
+    uint32_t mult_denom;
+    si5351_ms_config_t ms_conf;
+} si5351_ms_table_entry_t;
+
+typedef struct {
+    si5351_ms_table_entry_t key_conf;
+    int32_t err_ppb;
+    uint32_t last_used;
+} si5351_ms_cache_entry_t;
+
+typedef struct {
+    si5351_clk_src clksrc;
+    uint32_t mult_numer;    // 0 = output unused
+    uint32_t mult_denom;
+} si5351_out_req_t;
+
+typedef struct {
+    uint8_t pll_used;
+    si5351_clk_src pll_src[2];
+    uint8_t clkin_div_regval;
+    si5351_pll_msn_config_t pll_msn_config[2];
+    uint8_t out_used;
+    si5351_pll_ch out_pll[8];
+    si5351_out_ms_config_t out_ms_config[8];
+    int32_t err_ppb[8];
+} si5351_plan_t;
+
+// Counters for measuring bus traffic and solver usage per operation
+typedef struct {
+    uint32_t write_xfers;
+    uint32_t bytes_written;
+    uint32_t read_xfers;
+    uint32_t solves;
+    uint32_t cache_hits;
+} si5351_stats_t;
+
+// Pending PLL switch of si5351_set_frac_mult_pingpong()
+typedef struct {
+    uint8_t pending;
+    si5351_out_ch out_ch;
+    si5351_pll_ch pll_ch;
+    uint16_t polls;
+} si5351_pingpong_t;
+
+typedef struct {
+    uint32_t i2cm_base;
+    uint8_t i2c_addr;
+    uint32_t xtal_freq;
+    si5351_pll_msn_config_t pll_msn_config[2];
+    si5351_pll_msn_config_t pll_msn_nominal[2];
+    si5351_out_ms_config_t out_ms_config[8];
+    int32_t frac_err_ppb;
+    si5351_ms_cache_entry_t ms_cache[SI_MS_CACHE_SIZE];
+    uint32_t ms_cache_tick;
+    si5351_state state;
+    uint8_t lol_mask;
+    uint16_t polls;
+    si5351_stats_t stats;
+    si5351_pingpong_t pingpong;
+} si5351_dev;
+
+int si5351_calc_frac_mult(si5351_clk_src clksrc, uint32_t clksrc_hz, uint32_t mult_numer, uint32_t mult_denom, si5351_ms_config_t *ms_conf, int32_t *err_ppb);
+
+int si5351_set_frac_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch out_ch, si5351_clk_src clksrc, uint32_t clkin_hz, uint32_t mult_numer, uint32_t mult_denom, const si5351_ms_config_t *ms_conf);
 
 int si5351_set_integer_mult(si5351_dev *dev, si5351_pll_ch pll_ch, si5351_out_ch out_ch, si5351_clk_src clksrc, uint32_t clkin_hz, uint8_t mult, uint8_t outdiv);
 
+int si5351_set_frac_mult_pingpong(si5351_dev *dev, si5351_out_ch out_ch, si5351_clk_src clksrc, uint32_t clkin_hz, uint32_t mult_numer, uint32_t mult_denom, const si5351_ms_config_t *ms_conf);
+
+int si5351_pingpong_poll(si5351_dev *dev);
+
+int si5351_calc_plan(const si5351_out_req_t *req, uint32_t xtal_hz, uint32_t clkin_hz, si5351_plan_t *plan);
+
+int si5351_apply_plan(si5351_dev *dev, const si5351_plan_t *plan);
+
+int si5351_trim_pll(si5351_dev *dev, si5351_pll_ch pll_ch, int32_t trim_ppb);
+
 void si5351_disable_outputs(si5351_dev *dev, uint8_t out_ch_mask);
 
-void si5351_init(si5351_dev *dev);
+void si5351_init_start(si5351_dev *dev);
+
+int si5351_lock_start(si5351_dev *dev, uint8_t lol_mask);
+
+si5351_state si5351_poll(si5351_dev *dev, uint8_t *events);
+
+int si5351_init(si5351_dev *dev);
 
 #endif /* SI5351_H_ */
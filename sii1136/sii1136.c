@@ -22,6 +22,12 @@
 #include "sii1136.h"
 #include "i2c_opencores.h"
 
+// Deferred write set tags
+#define SII1136_REGQ_AVI_IFR    0
+#define SII1136_REGQ_AUDIO_IFR  1
+#define SII1136_REGQ_HDR_IFR    2
+#define SII1136_REGQ_VRR_IFR    3
+
 const sii1136_config sii1136_cfg_default = {
     .tx_mode = TX_HDMI_RGB_FULL,
     .audio_fmt = AUDIO_I2S,
@@ -33,6 +39,9 @@ const sii1136_config sii1136_cfg_default = {
 
 void sii1136_writereg(sii1136_dev *dev, uint8_t regaddr, uint8_t data)
 {
+    if (dev->regq)
+        regq_drop(dev->regq, dev->i2cm_base, dev->i2c_addr, regaddr, 1);
+
     I2C_start(dev->i2cm_base, dev->i2c_addr, 0);
     I2C_write(dev->i2cm_base, regaddr, 0);
     I2C_write(dev->i2cm_base, data, 1);
@@ -49,6 +58,27 @@ uint8_t sii1136_readreg(sii1136_dev *dev, uint8_t regaddr)
     return I2C_read(dev->i2cm_base,1);
 }
 
+static void sii1136_regq_begin(sii1136_dev *dev, uint8_t tag) {
+    if (dev->regq)
+        regq_begin(dev->regq, dev->i2cm_base, dev->i2c_addr, tag);
+}
+
+// Write register at next vertical blank if deferred write queue is attached (and not full)
+static void sii1136_writereg_vsync(sii1136_dev *dev, uint8_t regaddr, uint8_t data) {
+    if (!dev->regq || (regq_write(dev->regq, dev->i2cm_base, dev->i2c_addr, regaddr, data) != 0))
+        sii1136_writereg(dev, regaddr, data);
+}
+
+// Read register value including not yet flushed deferred writes
+static uint8_t sii1136_readreg_vsync(sii1136_dev *dev, uint8_t regaddr) {
+    uint8_t data;
+
+    if (dev->regq && regq_read_pending(dev->regq, dev->i2cm_base, dev->i2c_addr, regaddr, &data))
+        return data;
+
+    return sii1136_readreg(dev, regaddr);
+}
+
 void sii1136_read_eddc_edid(sii1136_dev *dev, unsigned char *buf, unsigned len) {
     int i;
 
@@ -173,33 +203,57 @@ void sii1136_update_infoframe(sii1136_dev *dev, HDMI_infoframe_id_t type, HDMI_i
     // Calculate CRC, set type and commit last byte (triggers update)
     if (type == HDMI_AVI_INFOFRAME_TYPE) {
         for (ifr_reg=0x0D; ifr_reg<=0x18; ifr_reg++)
-            crc += sii1136_readreg(dev, ifr_reg);
+            crc += sii1136_readreg_vsync(dev, ifr_reg);
 
         crc += lastbyte;
         crc = 0x100 - crc;
 
-        sii1136_writereg(dev, 0x0C, crc);
+        sii1136_writereg_vsync(dev, 0x0C, crc);
 
         // commit update
-        sii1136_writereg(dev, 0x19, lastbyte);
+        sii1136_writereg_vsync(dev, 0x19, lastbyte);
     } else {
-        sii1136_writereg(dev, 0xC0, ((1<<7) | type));
-        sii1136_writereg(dev, 0xC1, ver);
-        sii1136_writereg(dev, 0xC2, len);
+        sii1136_writereg_vsync(dev, 0xC0, ((1<<7) | type));
+        sii1136_writereg_vsync(dev, 0xC1, ver);
+        sii1136_writereg_vsync(dev, 0xC2, len);
 
         for (ifr_reg=0xC4; ifr_reg<0xC3+len; ifr_reg++)
-            crc += sii1136_readreg(dev, ifr_reg);
+            crc += sii1136_readreg_vsync(dev, ifr_reg);
 
         crc += lastbyte;
         crc = 0x100 - crc;
 
-        sii1136_writereg(dev, 0xC3, crc);
+        sii1136_writereg_vsync(dev, 0xC3, crc);
 
         // commit update
-        sii1136_writereg(dev, 0xC3+len, lastbyte);
+        sii1136_writereg_vsync(dev, 0xC3+len, lastbyte);
         if ((type != HDMI_AUDIO_INFOFRAME_TYPE) && (0xC3+len != 0xDE))
-            sii1136_writereg(dev, 0xDE, 0x00);
+            sii1136_writereg_vsync(dev, 0xDE, 0x00);
+    }
+}
+
+// Update AVI infoframe bytes. With deferred write queue attached the full infoframe is
+// rewritten so that pending AVI updates coalesce into a single write set.
+static void sii1136_update_avi_infoframe(sii1136_dev *dev, uint8_t regaddr1, uint8_t data1, uint8_t regaddr2, uint8_t data2) {
+    uint8_t avi[HDMI_AVI_INFOFRAME_LEN-1];
+    int i;
+
+    if (dev->regq) {
+        for (i=0; i<sizeof(avi); i++)
+            avi[i] = sii1136_readreg_vsync(dev, 0x0D+i);
+        avi[regaddr1-0x0D] = data1;
+        avi[regaddr2-0x0D] = data2;
+
+        sii1136_regq_begin(dev, SII1136_REGQ_AVI_IFR);
+        for (i=0; i<sizeof(avi); i++)
+            sii1136_writereg_vsync(dev, 0x0D+i, avi[i]);
+    } else {
+        sii1136_writereg(dev, regaddr1, data1);
+        sii1136_writereg(dev, regaddr2, data2);
     }
+
+    // Commit AVI infoframe update
+    sii1136_update_infoframe(dev, HDMI_AVI_INFOFRAME_TYPE, HDMI_AVI_INFOFRAME_VER, HDMI_AVI_INFOFRAME_LEN, 0x00);
 }
 
 void sii1136_set_audio(sii1136_dev *dev, HDMI_audio_fmt_t fmt, HDMI_i2s_fs_t i2s_fs, HDMI_i2s_stereo_cfg_t i2s_stereo_cfg, HDMI_audio_cc_t cc_val, HDMI_audio_ca_t ca_val) {
@@ -266,13 +320,14 @@ void sii1136_set_audio(sii1136_dev *dev, HDMI_audio_fmt_t fmt, HDMI_i2s_fs_t i2s
     }
 
     // Setup audio infoframe
-    sii1136_writereg(dev, 0xBF, 0xc2);
-    sii1136_writereg(dev, 0xC4, cc_val);
-    sii1136_writereg(dev, 0xC5, 0x00);
-    sii1136_writereg(dev, 0xC6, 0x00);
-    sii1136_writereg(dev, 0xC7, ca_val);
+    sii1136_regq_begin(dev, SII1136_REGQ_AUDIO_IFR);
+    sii1136_writereg_vsync(dev, 0xBF, 0xc2);
+    sii1136_writereg_vsync(dev, 0xC4, cc_val);
+    sii1136_writereg_vsync(dev, 0xC5, 0x00);
+    sii1136_writereg_vsync(dev, 0xC6, 0x00);
+    sii1136_writereg_vsync(dev, 0xC7, ca_val);
     for (ifr_reg=0xC8; ifr_reg<0xC3+HDMI_AUDIO_INFOFRAME_LEN; ifr_reg++)
-        sii1136_writereg(dev, ifr_reg, 0x00);
+        sii1136_writereg_vsync(dev, ifr_reg, 0x00);
 
     // Commit audio infoframe update
     sii1136_update_infoframe(dev, HDMI_AUDIO_INFOFRAME_TYPE, HDMI_AUDIO_INFOFRAME_VER, HDMI_AUDIO_INFOFRAME_LEN, 0x00);
@@ -287,10 +342,11 @@ void sii1136_set_hdr(sii1136_dev *dev, uint8_t hdr_enable) {
     uint8_t ifr_reg;
 
     // Setup HDR Infoframe
-    sii1136_writereg(dev, 0xBF, hdr_enable ? 0xc4 : 0x04);
-    sii1136_writereg(dev, 0xC4, hdr_enable ? 3 : 0);
+    sii1136_regq_begin(dev, SII1136_REGQ_HDR_IFR);
+    sii1136_writereg_vsync(dev, 0xBF, hdr_enable ? 0xc4 : 0x04);
+    sii1136_writereg_vsync(dev, 0xC4, hdr_enable ? 3 : 0);
     for (ifr_reg=0xC5; ifr_reg<0xC3+HDMI_HDR_INFOFRAME_LEN; ifr_reg++)
-        sii1136_writereg(dev, ifr_reg, 0x00);
+        sii1136_writereg_vsync(dev, ifr_reg, 0x00);
 
     // Commit infoframe update
     sii1136_update_infoframe(dev, HDMI_HDR_INFOFRAME_TYPE, HDMI_HDR_INFOFRAME_VER, HDMI_HDR_INFOFRAME_LEN, 0x00);
@@ -300,12 +356,13 @@ void sii1136_set_vrr(sii1136_dev *dev, uint8_t vrr_mode) {
     uint8_t ifr_reg;
 
     // Setup Freesync Infoframe
-    sii1136_writereg(dev, 0xBF, vrr_mode ? 0xc1 : 0x01);
-    sii1136_writereg(dev, 0xC4, vrr_mode ? 0x1a : 0);
+    sii1136_regq_begin(dev, SII1136_REGQ_VRR_IFR);
+    sii1136_writereg_vsync(dev, 0xBF, vrr_mode ? 0xc1 : 0x01);
+    sii1136_writereg_vsync(dev, 0xC4, vrr_mode ? 0x1a : 0);
     for (ifr_reg=0xC5; ifr_reg<=0xC8; ifr_reg++)
-        sii1136_writereg(dev, ifr_reg, 0x00);
-    sii1136_writereg(dev, 0xC9, 0x07);
-    sii1136_writereg(dev, 0xCA, 40);
+        sii1136_writereg_vsync(dev, ifr_reg, 0x00);
+    sii1136_writereg_vsync(dev, 0xC9, 0x07);
+    sii1136_writereg_vsync(dev, 0xCA, 40);
 
     // Commit infoframe update
     sii1136_update_infoframe(dev, HDMI_SPD_INFOFRAME_TYPE, HDMI_VENDORSPEC_INFOFRAME_VER, HDMI_VENDORSPEC_INFOFRAME_LEN, 144);
@@ -337,12 +394,9 @@ void sii1136_set_tx_mode(sii1136_dev *dev, HDMI_tx_mode_t mode) {
         sii1136_enable_tmds_output(dev, 1);
     }
 
-    // Setup AVI InfoFrame
-    sii1136_writereg(dev, 0x0D, 0x02 | ((mode==TX_HDMI_YCBCR444)<<6));  // RGB/YCbCr444, no overscan
-    sii1136_writereg(dev, 0x0F, (mode==TX_HDMI_RGB_LIM) ? 0x04 : 0x08); // Full/limited range RGB
-
-    // Commit AVI infoframe update
-    sii1136_update_infoframe(dev, HDMI_AVI_INFOFRAME_TYPE, HDMI_AVI_INFOFRAME_VER, HDMI_AVI_INFOFRAME_LEN, 0x00);
+    // Setup AVI InfoFrame: RGB/YCbCr444, no overscan, full/limited range RGB
+    sii1136_update_avi_infoframe(dev, 0x0D, 0x02 | ((mode==TX_HDMI_YCBCR444)<<6),
+                                      0x0F, (mode==TX_HDMI_RGB_LIM) ? 0x04 : 0x08);
 
     // Set other Infoframes
     sii1136_set_audio(dev, dev->cfg.audio_fmt, dev->cfg.i2s_fs, dev->cfg.i2s_stereo_cfg, dev->cfg.audio_cc_val, dev->cfg.audio_ca_val);
@@ -369,11 +423,7 @@ void sii1136_init_mode(sii1136_dev *dev, uint8_t pixelrep, uint8_t pixelrep_info
     sii1136_writereg(dev, SII1136_PCLK_MSB, (pclk_hz/10000) >> 8);
 
     // Update AVI infoframe
-    sii1136_writereg(dev, 0x10, vic);
-    sii1136_writereg(dev, 0x11, pixelrep_infoframe);
-
-    // Commit AVI infoframe update
-    sii1136_update_infoframe(dev, HDMI_AVI_INFOFRAME_TYPE, HDMI_AVI_INFOFRAME_VER, HDMI_AVI_INFOFRAME_LEN, 0x00);
+    sii1136_update_avi_infoframe(dev, 0x10, vic, 0x11, pixelrep_infoframe);
 
     // Set other Infoframes
     sii1136_set_audio(dev, dev->cfg.audio_fmt, dev->cfg.i2s_fs, dev->cfg.i2s_stereo_cfg, dev->cfg.audio_cc_val, dev->cfg.audio_ca_val);
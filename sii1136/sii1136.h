@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include "sysconfig.h"
 #include "hdmi.h"
+#include "regq.h"
 #include "sii1136_regs.h"
 
 typedef struct {
@@ -47,6 +48,7 @@ typedef struct {
     uint32_t pclk_hz;
     HDMI_vic_t vic;
     sii1136_config cfg;
+    regq_t *regq;
 } sii1136_dev;
 
 int sii1136_init(sii1136_dev *dev);
@@ -0,0 +1,35 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef I2C_OPENCORES_H_
+#define I2C_OPENCORES_H_
+
+// Host replacement for the i2c_opencores driver API, backed by a simulated bus
+
+#include <stdint.h>
+
+typedef uint8_t alt_u8;
+typedef uint32_t alt_u32;
+
+int I2C_start(alt_u32 base, alt_u32 add, alt_u32 read);
+
+alt_u32 I2C_read(alt_u32 base, alt_u32 last);
+
+alt_u32 I2C_write(alt_u32 base, alt_u8 data, alt_u32 last);
+
+#endif /* I2C_OPENCORES_H_ */
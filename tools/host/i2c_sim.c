@@ -0,0 +1,67 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <string.h>
+#include "i2c_opencores.h"
+#include "i2c_sim.h"
+
+i2c_sim_stats_t i2c_sim_stats;
+
+static uint8_t sim_regs[128][256];
+static uint8_t cur_addr;
+static uint8_t cur_ptr;
+static uint8_t ptr_pending;
+
+void i2c_sim_reset(void) {
+    memset(sim_regs, 0x00, sizeof(sim_regs));
+    memset(&i2c_sim_stats, 0x00, sizeof(i2c_sim_stats_t));
+    cur_addr = 0;
+    cur_ptr = 0;
+    ptr_pending = 0;
+}
+
+uint8_t* i2c_sim_regs(uint8_t i2c_addr) {
+    return sim_regs[i2c_addr & 0x7f];
+}
+
+int I2C_start(alt_u32 base, alt_u32 add, alt_u32 read) {
+    cur_addr = add & 0x7f;
+    ptr_pending = !read;
+    i2c_sim_stats.starts++;
+
+    return 0;
+}
+
+alt_u32 I2C_read(alt_u32 base, alt_u32 last) {
+    i2c_sim_stats.bytes_read++;
+
+    return sim_regs[cur_addr][cur_ptr++];
+}
+
+alt_u32 I2C_write(alt_u32 base, alt_u8 data, alt_u32 last) {
+    i2c_sim_stats.bytes_written++;
+
+    if (ptr_pending) {
+        cur_ptr = data;
+        ptr_pending = 0;
+    } else {
+        sim_regs[cur_addr][cur_ptr++] = data;
+    }
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef I2C_SIM_H_
+#define I2C_SIM_H_
+
+#include <stdint.h>
+
+// Simulated I2C bus: every 7-bit address is a device with 256 byte-wide registers and
+// auto-incrementing register pointer. Registers read back what was last written.
+
+typedef struct {
+    uint32_t starts;
+    uint32_t bytes_written;
+    uint32_t bytes_read;
+} i2c_sim_stats_t;
+
+extern i2c_sim_stats_t i2c_sim_stats;
+
+void i2c_sim_reset(void);
+
+uint8_t* i2c_sim_regs(uint8_t i2c_addr);
+
+#endif /* I2C_SIM_H_ */
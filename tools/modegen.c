@@ -0,0 +1,238 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Offline generator of mode_table[] (see common/mode_table.h). Every vmode_class catalogue
+// mode is combined with line multipliers 1..MODE_TABLE_MAX_MULT, and the Si5351 solver,
+// ISL51002 frontend setup and output VIC / pixel repetition selection are run for each
+// combination on all CPU cores. Results are emitted in catalogue order, so output does not
+// depend on thread count.
+//
+// Audio N is not part of the table: it depends only on sample rate (const table in
+// adv7513 driver, SiI1136 selects it internally) and CTS is measured by the transmitter.
+//
+// Usage: modegen [-j <threads>] [-o <file>]
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "mode_table.h"
+#include "vmode_class.h"
+
+typedef struct {
+    int mode_id;
+    uint8_t mult;
+    int out_mode_id;
+} modegen_job_t;
+
+static modegen_job_t *jobs;
+static mode_table_out_t *job_out;
+static int num_jobs;
+static int next_job;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static mode_table_entry_t *entries;
+static int num_modes;
+
+// Tri-level sync is used by HD component sources
+static uint8_t modegen_sync_trilevel(const vmode_timing_t *t) {
+    return (t->std == VMODE_STD_CEA) && (t->h_active >= 1280);
+}
+
+// Output timing of line multiplied mode. Interlaced input is line doubled to progressive.
+static int modegen_classify_output(int mode_id, uint8_t mult) {
+    const vmode_timing_t *t = vmode_get_timing(mode_id);
+    vmode_meas_t meas;
+
+    // Passthrough
+    if (mult == 1)
+        return mode_id;
+
+    if (t->interlace && ((t->v_total*mult) % 2))
+        return -1;
+
+    memset(&meas, 0x00, sizeof(vmode_meas_t));
+    meas.h_active = t->h_active;
+    meas.h_total = t->h_total;
+    meas.v_active = t->v_active*mult;
+    meas.v_total = t->interlace ? (t->v_total*mult)/2 : t->v_total*mult;
+    meas.pclk_hz = t->pclk_hz*mult;
+
+    return vmode_classify(&meas);
+}
+
+static void modegen_run_job(const modegen_job_t *job, mode_table_out_t *out) {
+    const vmode_timing_t *t = vmode_get_timing(job->mode_id);
+
+    memset(out, 0x00, sizeof(mode_table_out_t));
+
+    if (((uint64_t)t->pclk_hz*job->mult > SI_MAX_OUTPUT_FREQ) ||
+        (si5351_calc_frac_mult(SI_CLKIN, t->pclk_hz, job->mult, 1, &out->ms_conf, &out->err_ppb) < 0))
+        return;
+
+    out->valid = 1;
+    out->vic = vmode_get_vic(job->out_mode_id, 0);
+    out->vic_16x9 = vmode_get_vic(job->out_mode_id, 1);
+    if (out->vic_16x9 == out->vic)
+        out->vic_16x9 = HDMI_Unknown;
+    out->pixelrep_ifr = vmode_get_pixelrep_ifr(job->out_mode_id);
+}
+
+static void* modegen_worker(void *arg) {
+    int i;
+
+    while (1) {
+        pthread_mutex_lock(&job_lock);
+        i = next_job++;
+        pthread_mutex_unlock(&job_lock);
+
+        if (i >= num_jobs)
+            break;
+
+        modegen_run_job(&jobs[i], &job_out[i]);
+    }
+
+    return NULL;
+}
+
+static void modegen_calc_fe(int mode_id, isl51002_frontend_setup *fe) {
+    const vmode_timing_t *t = vmode_get_timing(mode_id);
+    isl51002_dev dev;
+
+    memset(&dev, 0x00, sizeof(isl51002_dev));
+    isl_get_default_cfg(&dev.cfg);
+    dev.sync_trilevel = modegen_sync_trilevel(t);
+
+    isl_calc_frontend_setup(&dev, t->h_total, t->pclk_hz, fe);
+}
+
+static void modegen_print_ms_conf(FILE *f, const si5351_ms_config_t *c) {
+    fprintf(f, "{%lu, %lu, %lu, %lu, %lu, %lu, %u, %u, %u}", (unsigned long)c->msn_p1, (unsigned long)c->msn_p2, (unsigned long)c->msn_p3,
+            (unsigned long)c->ms_p1, (unsigned long)c->ms_p2, (unsigned long)c->ms_p3, c->clkin_div_regval, c->outdiv, c->divby4);
+}
+
+static void modegen_emit(FILE *f) {
+    const vmode_timing_t *t;
+    const mode_table_out_t *out;
+    const isl51002_frontend_setup *fe;
+    int i, m;
+
+    fprintf(f, "// Generated by tools/modegen, do not edit\n\n");
+    fprintf(f, "#include \"mode_table.h\"\n\n");
+    fprintf(f, "const mode_table_entry_t mode_table[] = {\n");
+
+    for (i=0; i<num_modes; i++) {
+        t = vmode_get_timing(i);
+        fe = &entries[i].fe;
+
+        fprintf(f, "    // %d: %s\n", i, t->name);
+        fprintf(f, "    {{%u, %u, %u, %u},\n", fe->htotal, fe->clamp_start_px, fe->clamp_width_px, fe->afe_bw_sel);
+        fprintf(f, "     {\n");
+        for (m=0; m<MODE_TABLE_MAX_MULT; m++) {
+            out = &entries[i].out[m];
+            fprintf(f, "        {%u, %u, %u, %u, %ld, ", out->valid, out->vic, out->vic_16x9, out->pixelrep_ifr, (long)out->err_ppb);
+            modegen_print_ms_conf(f, &out->ms_conf);
+            fprintf(f, "},  // x%d\n", m+1);
+        }
+        fprintf(f, "     }},\n");
+    }
+
+    fprintf(f, "};\n\n");
+    fprintf(f, "const int mode_table_size = sizeof(mode_table)/sizeof(mode_table_entry_t);\n");
+}
+
+int main(int argc, char **argv) {
+    pthread_t *threads;
+    const char *outfile = NULL;
+    FILE *f;
+    long num_threads;
+    int i, j;
+
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (i=1; i<argc; i++) {
+        if (!strcmp(argv[i], "-j") && (i+1 < argc)) {
+            num_threads = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-o") && (i+1 < argc)) {
+            outfile = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [-j <threads>] [-o <file>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (num_threads < 1)
+        num_threads = 1;
+
+    while (vmode_get_timing(num_modes))
+        num_modes++;
+
+    entries = calloc(num_modes, sizeof(mode_table_entry_t));
+    jobs = calloc(num_modes*MODE_TABLE_MAX_MULT, sizeof(modegen_job_t));
+    job_out = calloc(num_modes*MODE_TABLE_MAX_MULT, sizeof(mode_table_out_t));
+    threads = calloc(num_threads, sizeof(pthread_t));
+    if (!entries || !jobs || !job_out || !threads) {
+        fprintf(stderr, "out of memory\n");
+        return 2;
+    }
+
+    // Classifier builds its index on first use, so it is run here before workers start
+    for (i=0; i<num_modes; i++) {
+        modegen_calc_fe(i, &entries[i].fe);
+
+        for (j=0; j<MODE_TABLE_MAX_MULT; j++) {
+            jobs[num_jobs].mode_id = i;
+            jobs[num_jobs].mult = j+1;
+            jobs[num_jobs].out_mode_id = modegen_classify_output(i, j+1);
+            num_jobs++;
+        }
+    }
+
+    for (i=0; i<num_threads; i++) {
+        if (pthread_create(&threads[i], NULL, modegen_worker, NULL)) {
+            fprintf(stderr, "pthread_create failed\n");
+            return 2;
+        }
+    }
+    for (i=0; i<num_threads; i++)
+        pthread_join(threads[i], NULL);
+
+    for (i=0; i<num_jobs; i++)
+        entries[jobs[i].mode_id].out[jobs[i].mult-1] = job_out[i];
+
+    if (outfile) {
+        f = fopen(outfile, "w");
+        if (!f) {
+            perror(outfile);
+            return 2;
+        }
+    } else {
+        f = stdout;
+    }
+
+    modegen_emit(f);
+
+    if (f != stdout)
+        fclose(f);
+
+    fprintf(stderr, "%d modes, %d entries, %ld threads\n", num_modes, num_jobs, num_threads);
+
+    return 0;
+}
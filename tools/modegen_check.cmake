@@ -0,0 +1,14 @@
+# Output of modegen must not depend on thread count
+
+execute_process(COMMAND ${MODEGEN} -j 1 -o ${OUT_DIR}/mode_table_j1.c RESULT_VARIABLE rc1)
+execute_process(COMMAND ${MODEGEN} -j 8 -o ${OUT_DIR}/mode_table_j8.c RESULT_VARIABLE rc8)
+
+if(NOT rc1 EQUAL 0 OR NOT rc8 EQUAL 0)
+    message(FATAL_ERROR "modegen failed")
+endif()
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUT_DIR}/mode_table_j1.c ${OUT_DIR}/mode_table_j8.c RESULT_VARIABLE rc)
+
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "modegen output differs between 1 and 8 threads")
+endif()
@@ -0,0 +1,449 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Host benchmark of Si5351 divider math over a corpus of real clock ratios. Each case is
+// programmed on the simulated bus via si5351_set_frac_mult() (and si5351_set_integer_mult()
+// for integer line multipliers) starting from a freshly initialized device. Achieved output
+// frequency is decoded back from the written registers and compared exactly against the
+// requested ratio.
+//
+// Usage: si5351_bench [--baseline <file>] [--update-baseline] [--max-solve-us <us>]
+//
+// With --baseline, per-case results are compared against the file and the run fails if any
+// case fails to program, gets a larger frequency error, loses integer mode or needs more
+// register writes than recorded. --update-baseline rewrites the file from current results.
+// Solve time is host CPU time and only gated against an absolute limit.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "si5351.h"
+#include "i2c_sim.h"
+
+#define BENCH_XTAL_HZ           27000000UL
+#define BENCH_I2C_ADDR          0x60
+#define BENCH_NAME_LEN          64
+#define BENCH_MAX_CASES         256
+#define BENCH_MIN_TIMING_CLKS   (CLOCKS_PER_SEC/100)
+#define BENCH_MAX_SOLVE_US      2000
+
+typedef enum {
+    BENCH_FRAC = 0,
+    BENCH_INT
+} bench_func_t;
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    bench_func_t func;
+    si5351_clk_src clksrc;
+    uint32_t clkin_hz;
+    uint32_t mult_numer;
+    uint32_t mult_denom;
+} bench_case_t;
+
+typedef struct {
+    int ok;
+    int64_t err_ppb;
+    int int_mode;
+    uint32_t writes;
+    uint32_t bytes;
+    double solve_us;
+} bench_result_t;
+
+// CEA-861 pixel clock families (kHz), generated from XTAL at both 60Hz and 59.94Hz rate
+static const uint32_t vic_pclk_khz[] = {25200, 27000, 54000, 59400, 74250, 82500, 99000, 108000, 148500, 165000, 198000, 216000, 297000};
+
+// Analog sampling clocks (Hz) fed to CLKIN, multiplied by line multipliers
+static const uint32_t line_clkin_hz[] = {10738635, 12272727, 13500000, 14318180, 18000000, 25175000, 27000000, 74250000};
+
+// Fractional scaling ratios between input and output line rate
+static const struct {
+    uint32_t numer;
+    uint32_t denom;
+} line_frac_mult[] = { {3, 2}, {9, 4}, {5, 4}, {8, 3} };
+
+// Frame-locked output from analog source: CLKIN (Hz), source total, output total
+static const struct {
+    uint32_t clkin_hz;
+    uint16_t src_h_total;
+    uint16_t src_v_total;
+    uint16_t out_h_total;
+    uint16_t out_v_total;
+} framelock[] = {
+    {21477272, 1364, 262, 2200, 1125},  // SNES 240p -> 1080p
+    {13500000, 1716, 263, 2200, 1125},  // 240p @ 2x sampling -> 1080p
+    {13500000, 864, 625, 2640, 1125},   // 576i -> 1080p50
+    {25175000, 800, 525, 1650, 750},    // VGA 480p -> 720p
+};
+
+// Audio master clocks (Hz) for 32/44.1/48kHz families at 256fs/512fs/1024fs
+static const uint32_t audio_mclk_hz[] = {8192000, 11289600, 12288000, 16384000, 22579200, 24576000, 45158400, 49152000};
+
+static bench_case_t cases[BENCH_MAX_CASES];
+static int num_cases;
+
+static void add_case(bench_func_t func, si5351_clk_src clksrc, uint32_t clkin_hz, uint32_t mult_numer, uint32_t mult_denom, const char *name) {
+    bench_case_t *c;
+
+    if (num_cases == BENCH_MAX_CASES) {
+        fprintf(stderr, "too many cases\n");
+        exit(2);
+    }
+
+    c = &cases[num_cases++];
+    snprintf(c->name, BENCH_NAME_LEN, "%s:%s", (func == BENCH_INT) ? "int" : "frac", name);
+    c->func = func;
+    c->clksrc = clksrc;
+    c->clkin_hz = clkin_hz;
+    c->mult_numer = mult_numer;
+    c->mult_denom = mult_denom;
+}
+
+static void build_corpus() {
+    char name[BENCH_NAME_LEN];
+    uint32_t clksrc_hz;
+    int i, j;
+
+    for (i=0; i<sizeof(vic_pclk_khz)/sizeof(vic_pclk_khz[0]); i++) {
+        snprintf(name, BENCH_NAME_LEN, "vic_%lukhz", (unsigned long)vic_pclk_khz[i]);
+        add_case(BENCH_FRAC, SI_XTAL, 0, vic_pclk_khz[i], BENCH_XTAL_HZ/1000, name);
+        snprintf(name, BENCH_NAME_LEN, "vic_%lukhz_1001", (unsigned long)vic_pclk_khz[i]);
+        add_case(BENCH_FRAC, SI_XTAL, 0, vic_pclk_khz[i], (BENCH_XTAL_HZ/1000)*1001/1000, name);
+    }
+
+    for (i=0; i<sizeof(line_clkin_hz)/sizeof(line_clkin_hz[0]); i++) {
+        clksrc_hz = line_clkin_hz[i];
+
+        for (j=2; j<=5; j++) {
+            if (clksrc_hz*j > SI_MAX_OUTPUT_FREQ)
+                break;
+            snprintf(name, BENCH_NAME_LEN, "line_%luhz_x%d", (unsigned long)clksrc_hz, j);
+            add_case(BENCH_FRAC, SI_CLKIN, clksrc_hz, j, 1, name);
+            add_case(BENCH_INT, SI_CLKIN, clksrc_hz, j, 1, name);
+        }
+
+        for (j=0; j<sizeof(line_frac_mult)/sizeof(line_frac_mult[0]); j++) {
+            if ((uint64_t)clksrc_hz*line_frac_mult[j].numer/line_frac_mult[j].denom > SI_MAX_OUTPUT_FREQ)
+                continue;
+            snprintf(name, BENCH_NAME_LEN, "line_%luhz_x%lu/%lu", (unsigned long)clksrc_hz, (unsigned long)line_frac_mult[j].numer, (unsigned long)line_frac_mult[j].denom);
+            add_case(BENCH_FRAC, SI_CLKIN, clksrc_hz, line_frac_mult[j].numer, line_frac_mult[j].denom, name);
+        }
+    }
+
+    for (i=0; i<sizeof(framelock)/sizeof(framelock[0]); i++) {
+        snprintf(name, BENCH_NAME_LEN, "framelock_%luhz_%ux%u_%ux%u", (unsigned long)framelock[i].clkin_hz, framelock[i].src_h_total, framelock[i].src_v_total,
+                 framelock[i].out_h_total, framelock[i].out_v_total);
+        add_case(BENCH_FRAC, SI_CLKIN, framelock[i].clkin_hz, (uint32_t)framelock[i].out_h_total*framelock[i].out_v_total,
+                 (uint32_t)framelock[i].src_h_total*framelock[i].src_v_total, name);
+    }
+
+    for (i=0; i<sizeof(audio_mclk_hz)/sizeof(audio_mclk_hz[0]); i++) {
+        snprintf(name, BENCH_NAME_LEN, "audio_%luhz", (unsigned long)audio_mclk_hz[i]);
+        add_case(BENCH_FRAC, SI_XTAL, 0, audio_mclk_hz[i]/100, BENCH_XTAL_HZ/100, name);
+    }
+}
+
+// Multisynth ratio a+b/c = ((p1+512)*p3+p2)/(128*p3)
+static void decode_ms(const uint8_t *regs, uint64_t *numer, uint64_t *denom) {
+    uint32_t p1, p2, p3;
+
+    p3 = (((uint32_t)regs[5] >> 4) << 16) | ((uint32_t)regs[0] << 8) | regs[1];
+    p1 = (((uint32_t)regs[2] & 0x3) << 16) | ((uint32_t)regs[3] << 8) | regs[4];
+    p2 = (((uint32_t)regs[5] & 0xf) << 16) | ((uint32_t)regs[6] << 8) | regs[7];
+
+    if (((regs[2] >> 2) & 0x3) == 3) {
+        *numer = 4;
+        *denom = 1;
+    } else {
+        *numer = ((uint64_t)p1+512)*p3 + p2;
+        *denom = 128ULL*p3;
+    }
+}
+
+// Decode CLK0 of the simulated device and return its frequency error relative to requested ratio
+static int decode_output(const bench_case_t *c, int64_t *err_ppb, int *int_mode) {
+    const uint8_t *regs = i2c_sim_regs(BENCH_I2C_ADDR);
+    uint8_t clk_ctrl = regs[SI5351_CLK0_CTRL];
+    uint8_t pll_ch = (clk_ctrl >> 5) & 1;
+    uint8_t pll_src = regs[SI5351_PLL_SRC];
+    uint64_t msn_numer, msn_denom, ms_numer, ms_denom;
+    uint32_t clkin_div, rdiv;
+    __int128 achieved, requested;
+
+    if ((regs[SI5351_OEN_CTRL] & 1) || (clk_ctrl & (1<<7)))
+        return -1;
+
+    // Bypass outputs the clock source directly
+    if (((clk_ctrl >> 2) & 3) != 3) {
+        *err_ppb = (c->mult_numer == c->mult_denom) ? 0 : INT32_MAX;
+        *int_mode = 1;
+        return 0;
+    }
+
+    if (((pll_src >> (2+pll_ch)) & 1) != c->clksrc)
+        return -1;
+
+    clkin_div = (c->clksrc == SI_CLKIN) ? (1 << (pll_src >> 6)) : 1;
+    rdiv = 1 << ((regs[SI5351_MS0_BASE+2] >> 4) & 0x7);
+    decode_ms(regs + SI5351_MSNA_BASE + 8*pll_ch, &msn_numer, &msn_denom);
+    decode_ms(regs + SI5351_MS0_BASE, &ms_numer, &ms_denom);
+
+    // achieved/requested = (msn_numer*ms_denom*mult_denom) / (clkin_div*msn_denom*ms_numer*rdiv*mult_numer)
+    achieved = (__int128)msn_numer * ms_denom * c->mult_denom;
+    requested = (__int128)clkin_div * msn_denom * ms_numer * rdiv * c->mult_numer;
+    *err_ppb = (int64_t)(((achieved - requested) * 1000000000 + ((achieved >= requested) ? requested/2 : -requested/2)) / requested);
+
+    *int_mode = ((regs[SI5351_CLK6_CTRL+pll_ch] & (1<<6)) != 0) && ((clk_ctrl & (1<<6)) != 0);
+
+    return 0;
+}
+
+static void init_dev(si5351_dev *dev) {
+    memset(dev, 0x00, sizeof(si5351_dev));
+    dev->i2cm_base = 0;
+    dev->i2c_addr = BENCH_I2C_ADDR;
+    dev->xtal_freq = BENCH_XTAL_HZ;
+
+    i2c_sim_reset();
+    si5351_init(dev);
+    // Reset state has all outputs disabled
+    i2c_sim_regs(BENCH_I2C_ADDR)[SI5351_OEN_CTRL] = 0xff;
+}
+
+static void run_case(const bench_case_t *c, bench_result_t *res) {
+    si5351_dev dev;
+    si5351_ms_config_t ms_conf;
+    int32_t solve_err_ppb;
+    uint32_t writes, bytes, iters;
+    clock_t t_start, t_elapsed;
+    int retval;
+
+    memset(res, 0x00, sizeof(bench_result_t));
+    init_dev(&dev);
+
+    writes = dev.stats.write_xfers;
+    bytes = dev.stats.bytes_written;
+    if (c->func == BENCH_INT)
+        retval = si5351_set_integer_mult(&dev, SI_PLLA, SI_CLK0, c->clksrc, c->clkin_hz, c->mult_numer, 0);
+    else
+        retval = si5351_set_frac_mult(&dev, SI_PLLA, SI_CLK0, c->clksrc, c->clkin_hz, c->mult_numer, c->mult_denom, NULL);
+    res->writes = dev.stats.write_xfers - writes;
+    res->bytes = dev.stats.bytes_written - bytes;
+
+    if ((retval < 0) || (decode_output(c, &res->err_ppb, &res->int_mode) < 0))
+        return;
+    res->ok = 1;
+
+    if (c->func == BENCH_INT)
+        return;
+
+    // Solver time, repeated until measurable
+    iters = 0;
+    t_start = clock();
+    do {
+        si5351_calc_frac_mult(c->clksrc, (c->clksrc == SI_CLKIN) ? c->clkin_hz : BENCH_XTAL_HZ, c->mult_numer, c->mult_denom, &ms_conf, &solve_err_ppb);
+        iters++;
+        t_elapsed = clock() - t_start;
+    } while (t_elapsed < BENCH_MIN_TIMING_CLKS);
+
+    res->solve_us = (1000000.0*t_elapsed/CLOCKS_PER_SEC) / iters;
+}
+
+static int64_t abs64(int64_t v) {
+    return (v < 0) ? -v : v;
+}
+
+static void print_summary(const bench_result_t *res) {
+    static const int64_t err_bin_ppb[] = {0, 1, 10, 100, 1000, 10000};
+    const int num_bins = sizeof(err_bin_ppb)/sizeof(err_bin_ppb[0]);
+    int hist[sizeof(err_bin_ppb)/sizeof(err_bin_ppb[0])+1] = {0};
+    int frac_ok = 0, int_hits = 0, ok = 0, num_solved = 0;
+    uint32_t writes_sum = 0, writes_max = 0;
+    double solve_sum = 0, solve_max = 0;
+    int64_t err, err_max = 0;
+    int i, j;
+
+    for (i=0; i<num_cases; i++) {
+        if (!res[i].ok)
+            continue;
+        ok++;
+
+        err = abs64(res[i].err_ppb);
+        for (j=0; (j<num_bins) && (err > err_bin_ppb[j]); j++) ;
+        hist[j]++;
+        if (err > err_max)
+            err_max = err;
+
+        int_hits += res[i].int_mode;
+        writes_sum += res[i].writes;
+        if (res[i].writes > writes_max)
+            writes_max = res[i].writes;
+
+        if (cases[i].func == BENCH_FRAC) {
+            frac_ok++;
+            num_solved++;
+            solve_sum += res[i].solve_us;
+            if (res[i].solve_us > solve_max)
+                solve_max = res[i].solve_us;
+        }
+    }
+
+    printf("\n%d/%d cases programmed\n", ok, num_cases);
+    printf("Frequency error distribution:\n");
+    for (j=0; j<=num_bins; j++) {
+        if (j == 0)
+            printf("  exact          %4d\n", hist[j]);
+        else if (j < num_bins)
+            printf("  <= %9.3fppm %4d\n", err_bin_ppb[j]/1000.0, hist[j]);
+        else
+            printf("  >  %9.3fppm %4d\n", err_bin_ppb[j-1]/1000.0, hist[j]);
+    }
+    printf("  max            %.3fppm\n", err_max/1000.0);
+    if (ok) {
+        printf("Integer mode hit rate: %d/%d (%.1f%%)\n", int_hits, ok, 100.0*int_hits/ok);
+        printf("Register writes per call: avg %.1f, max %lu\n", (double)writes_sum/ok, (unsigned long)writes_max);
+    }
+    if (num_solved)
+        printf("Solve time per call: avg %.2fus, max %.2fus\n", solve_sum/num_solved, solve_max);
+}
+
+static int write_baseline(const char *filename, const bench_result_t *res) {
+    FILE *f;
+    int i;
+
+    f = fopen(filename, "w");
+    if (!f) {
+        perror(filename);
+        return -1;
+    }
+
+    fprintf(f, "# si5351_bench baseline: name err_ppb int_mode writes\n");
+    for (i=0; i<num_cases; i++) {
+        if (res[i].ok)
+            fprintf(f, "%s %lld %d %lu\n", cases[i].name, (long long)res[i].err_ppb, res[i].int_mode, (unsigned long)res[i].writes);
+    }
+
+    fclose(f);
+
+    return 0;
+}
+
+static int check_baseline(const char *filename, const bench_result_t *res, double max_solve_us) {
+    FILE *f;
+    char line[128], name[BENCH_NAME_LEN];
+    long long err_ppb;
+    int int_mode, i, regressions = 0;
+    unsigned long writes;
+
+    f = fopen(filename, "r");
+    if (!f) {
+        perror(filename);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        if ((line[0] == '#') || (sscanf(line, "%63s %lld %d %lu", name, &err_ppb, &int_mode, &writes) != 4))
+            continue;
+
+        for (i=0; (i<num_cases) && strcmp(cases[i].name, name); i++) ;
+
+        if (i == num_cases) {
+            printf("REGRESSION %s: case removed from corpus\n", name);
+            regressions++;
+        } else if (!res[i].ok) {
+            printf("REGRESSION %s: programming failed\n", name);
+            regressions++;
+        } else {
+            if (abs64(res[i].err_ppb) > abs64(err_ppb)) {
+                printf("REGRESSION %s: error %lldppb (baseline %lldppb)\n", name, (long long)res[i].err_ppb, err_ppb);
+                regressions++;
+            }
+            if (res[i].int_mode < int_mode) {
+                printf("REGRESSION %s: integer mode lost\n", name);
+                regressions++;
+            }
+            if (res[i].writes > writes) {
+                printf("REGRESSION %s: %lu register writes (baseline %lu)\n", name, (unsigned long)res[i].writes, writes);
+                regressions++;
+            }
+        }
+    }
+    fclose(f);
+
+    for (i=0; i<num_cases; i++) {
+        if (res[i].solve_us > max_solve_us) {
+            printf("REGRESSION %s: solve time %.2fus exceeds %.2fus\n", cases[i].name, res[i].solve_us, max_solve_us);
+            regressions++;
+        }
+    }
+
+    return regressions;
+}
+
+int main(int argc, char **argv) {
+    static bench_result_t res[BENCH_MAX_CASES];
+    const char *baseline = NULL;
+    double max_solve_us = BENCH_MAX_SOLVE_US;
+    int update = 0, regressions, i;
+
+    for (i=1; i<argc; i++) {
+        if (!strcmp(argv[i], "--baseline") && (i+1 < argc)) {
+            baseline = argv[++i];
+        } else if (!strcmp(argv[i], "--update-baseline")) {
+            update = 1;
+        } else if (!strcmp(argv[i], "--max-solve-us") && (i+1 < argc)) {
+            max_solve_us = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--baseline <file>] [--update-baseline] [--max-solve-us <us>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    build_corpus();
+
+    printf("%-44s %12s %4s %6s %6s %9s\n", "case", "err_ppb", "int", "writes", "bytes", "solve_us");
+    for (i=0; i<num_cases; i++) {
+        run_case(&cases[i], &res[i]);
+        if (res[i].ok && (cases[i].func == BENCH_FRAC))
+            printf("%-44s %12lld %4d %6lu %6lu %9.2f\n", cases[i].name, (long long)res[i].err_ppb, res[i].int_mode,
+                   (unsigned long)res[i].writes, (unsigned long)res[i].bytes, res[i].solve_us);
+        else if (res[i].ok)
+            printf("%-44s %12lld %4d %6lu %6lu %9s\n", cases[i].name, (long long)res[i].err_ppb, res[i].int_mode,
+                   (unsigned long)res[i].writes, (unsigned long)res[i].bytes, "-");
+        else
+            printf("%-44s FAILED\n", cases[i].name);
+    }
+
+    print_summary(res);
+
+    if (!baseline)
+        return 0;
+
+    if (update)
+        return (write_baseline(baseline, res) < 0) ? 2 : 0;
+
+    regressions = check_baseline(baseline, res, max_solve_us);
+    if (regressions < 0)
+        return 2;
+
+    printf("\n%d regression(s) against %s\n", regressions, baseline);
+
+    return regressions ? 1 : 0;
+}
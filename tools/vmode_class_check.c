@@ -0,0 +1,120 @@
+//
+// Copyright (C) 2026  Markus Hiienkari <mhiienka@niksula.hut.fi>
+//
+// This file is part of Open Source Scan Converter project.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Check that timings as decoded by adv761x_decode_sync_status() from ADV761x HDMI map
+// registers are classified to the expected catalogue mode. Register values are built the
+// way the receiver reports them: vertical totals in half-lines per field, active lines
+// per field and interlace flag in FIELD1_HEIGHT.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "adv761x.h"
+#include "vmode_class.h"
+
+typedef struct {
+    const char *expected;   // NULL = must not classify
+    uint16_t h_active;
+    uint16_t h_total;
+    uint16_t field_active;
+    uint16_t field0_tot_halflines;
+    uint16_t field1_tot_halflines;
+    uint8_t interlace;
+    uint32_t pclk_hz;
+} vmode_check_t;
+
+static const vmode_check_t checks[] = {
+    {"1920x1080i60",        1920, 2200, 540, 1125, 1125, 1, 74250000},
+    {"1920x1080i60",        1920, 2200, 540, 1125, 1125, 1, 74175824},
+    {"1920x1080i50",        1920, 2640, 540, 1125, 1125, 1, 74250000},
+    {"720(1440)x480i60",    1440, 1716, 240, 525,  525,  1, 27000000},
+    {"720(1440)x480i60",    1440, 1716, 240, 525,  525,  1, 26973027},
+    {"720(1440)x576i50",    1440, 1728, 288, 625,  625,  1, 27000000},
+    {"1920x1080p60",        1920, 2200, 1080, 2250, 0,   0, 148500000},
+    {"1280x720p60",         1280, 1650, 720, 1500, 0,    0, 74175824},
+    {"720x480p60",          720,  858,  480, 1050, 0,    0, 27000000},
+    {"720(1440)x240p60",    1440, 1716, 240, 524,  0,    0, 27000000},
+    {"720(1440)x288p50",    1440, 1728, 288, 624,  0,    0, 27000000},
+    {"720x400@70",          720,  900,  400, 898,  0,    0, 28322000},
+    {"720x400@85",          720,  936,  400, 892,  0,    0, 35500000},
+    {"1280x1024@60",        1280, 1688, 1024, 2132, 0,   0, 108000000},
+    {NULL,                  1920, 2200, 540, 1125, 1125, 0, 74250000},
+    {NULL,                  1920, 2200, 1080, 1125, 1125, 1, 74250000},
+};
+
+static void set_word(adv761x_timing_snapshot *snap, uint8_t regaddr, uint16_t val) {
+    ADV761X_SNAP_REG(snap, regaddr) = val >> 8;
+    ADV761X_SNAP_REG(snap, regaddr+1) = val & 0xff;
+}
+
+static void build_snapshot(const vmode_check_t *c, adv761x_timing_snapshot *snap) {
+    memset(snap, 0x00, sizeof(adv761x_timing_snapshot));
+
+    snap->raw_stat_3 = (1<<1);
+    set_word(snap, ADV761X_LINE_WIDTH_1, c->h_active);
+    set_word(snap, ADV761X_TOTAL_LINE_WIDTH_1, c->h_total);
+    set_word(snap, ADV761X_FIELD0_HEIGHT_1, c->field_active);
+    set_word(snap, ADV761X_FIELD0_TOT_HEIGHT_1, c->field0_tot_halflines);
+
+    if (c->interlace) {
+        set_word(snap, ADV761X_FIELD1_HEIGHT_1, c->field_active);
+        ADV761X_SNAP_REG(snap, ADV761X_FIELD1_HEIGHT_1) |= (1<<5);
+        set_word(snap, ADV761X_FIELD1_TOT_HEIGHT_1, c->field1_tot_halflines);
+    }
+}
+
+int main() {
+    adv761x_timing_snapshot snap;
+    adv761x_sync_status ss;
+    vmode_meas_t meas;
+    const vmode_timing_t *t;
+    int i, mode_id, failures = 0;
+
+    for (i=0; i<sizeof(checks)/sizeof(checks[0]); i++) {
+        build_snapshot(&checks[i], &snap);
+        if (!adv761x_decode_sync_status(&snap, &ss)) {
+            printf("FAIL check %d: V params not decoded\n", i);
+            failures++;
+            continue;
+        }
+
+        memset(&meas, 0x00, sizeof(vmode_meas_t));
+        meas.h_active = ss.h_active;
+        meas.v_active = ss.v_active;
+        meas.h_total = ss.h_total;
+        meas.v_total = ss.v_total;
+        meas.interlace = ss.interlace_flag;
+        meas.pclk_hz = checks[i].pclk_hz;
+
+        mode_id = vmode_classify(&meas);
+        t = vmode_get_timing(mode_id);
+
+        printf("%ux%u%c total %ux%u @ %luHz -> %s\n", meas.h_active, meas.v_active, meas.interlace ? 'i' : 'p', meas.h_total, meas.v_total,
+               (unsigned long)meas.pclk_hz, t ? t->name : "unknown");
+
+        if ((checks[i].expected == NULL) ? (t != NULL) : (!t || strcmp(t->name, checks[i].expected))) {
+            printf("FAIL check %d: expected %s\n", i, checks[i].expected ? checks[i].expected : "unknown");
+            failures++;
+        }
+    }
+
+    printf("\n%d failure(s), classifier stats: %lu hash hits, %lu fallback hits, %lu misses\n", failures, (unsigned long)vmode_class_stats.hash_hits,
+           (unsigned long)vmode_class_stats.fallback_hits, (unsigned long)vmode_class_stats.misses);
+
+    return failures ? 1 : 0;
+}